@@ -0,0 +1,351 @@
+// Drives many agromaster::application sessions at once through Wt::Test::WTestEnvironment
+// and reports throughput, latency per action, resident memory per session and connection
+// pool waits.
+//
+// usage: agromaster_load_test [--users N] [--iterations N] [--connections N] [--login NAME]
+//     [--prefetch-delay MS]
+// The database comes from AGROMASTER_DB, as for the server, and is migrated first. Users log
+// in through the Login object of the auth widget: password checks run on the worker_pool
+// in production and are left out here. Resident memory is read from /proc and only
+// reported on Linux.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <Wt/Auth/AuthModel.h>
+#include <Wt/Auth/AuthWidget.h>
+#include <Wt/Auth/Identity.h>
+#include <Wt/Dbo/backend/Postgres.h>
+#include <Wt/Test/WTestEnvironment.h>
+#include <Wt/WAbstractItemDelegate.h>
+#include <Wt/WAbstractItemModel.h>
+#include <Wt/WDialog.h>
+#include <Wt/WEvent.h>
+#include <Wt/WInteractWidget.h>
+#include <Wt/WPushButton.h>
+#include <Wt/WTableView.h>
+
+#include "application.hpp"
+#include "connection_pool.hpp"
+#include "models/migrations.hpp"
+#include "sql_monitor.hpp"
+#include "worker_pool.hpp"
+
+#include "statistics.hpp"
+
+namespace
+{
+
+using namespace agromaster;
+using clock_type = std::chrono::steady_clock;
+
+struct options
+{
+    int users = 50;
+    int iterations = 20;
+    int connections = 10;
+    std::string login = "admin";
+    // Defaults of the server; a negative prefetch delay builds the pages on first visit only.
+    application::settings application_settings;
+};
+
+// Lets the main thread sample memory once every session is logged in.
+class gate
+{
+public:
+    explicit gate(int expected) : expected_(expected) {}
+
+    void arrive_and_wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++arrived_;
+        arrivals_.notify_all();
+        opened_.wait(lock, [this] { return open_; });
+    }
+
+    void wait_for_all()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        arrivals_.wait(lock, [this] { return arrived_ >= expected_; });
+    }
+
+    void open()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        opened_.notify_all();
+    }
+
+private:
+    const int expected_;
+    std::mutex mutex_;
+    std::condition_variable arrivals_;
+    std::condition_variable opened_;
+    int arrived_ = 0;
+    bool open_ = false;
+};
+
+class latencies
+{
+public:
+    void add(const std::map<std::string, std::vector<double>>& samples)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& action : samples)
+        {
+            std::vector<double>& all = samples_[action.first];
+            all.insert(all.end(), action.second.begin(), action.second.end());
+        }
+    }
+
+    const std::map<std::string, std::vector<double>>& samples() const { return samples_; }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, std::vector<double>> samples_;
+};
+
+long resident_bytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    long size = 0;
+    long resident = 0;
+    if (!(statm >> size >> resident))
+    {
+        return 0;
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+template <typename Widget>
+Widget* find_widget(Wt::WApplication& app, const char* name)
+{
+    return dynamic_cast<Widget*>(app.root()->find(name));
+}
+
+void simulate_user(
+    const options& config,
+    int user,
+    Wt::Dbo::SqlConnectionPool& pool,
+    worker_pool& password_workers,
+    gate& logged_in,
+    latencies& results)
+{
+    Wt::Test::WTestEnvironment environment(Wt::EntryPointType::Application);
+    application app(environment, pool, password_workers, config.application_settings);
+
+    std::map<std::string, std::vector<double>> samples;
+    auto timed = [&samples](const std::string& action, const std::function<void()>& run)
+    {
+        const clock_type::time_point started = clock_type::now();
+        run();
+        samples[action].push_back(
+            std::chrono::duration<double, std::milli>(clock_type::now() - started).count());
+    };
+
+    bool logged_in_ok = true;
+    try
+    {
+        auto auth = find_widget<Wt::Auth::AuthWidget>(app, object_name::auth);
+        timed("login",
+            [auth, &config]
+        {
+            Wt::Auth::User account = auth->model()->users().findWithIdentity(
+                Wt::Auth::Identity::LoginName, config.login);
+            auth->login().login(account);
+        });
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "user " << user << ": login failed: " << error.what() << std::endl;
+        logged_in_ok = false;
+    }
+    logged_in.arrive_and_wait();
+    if (!logged_in_ok)
+    {
+        return;
+    }
+
+    auto hothouses_table = find_widget<Wt::WTableView>(app, object_name::hothouses_table);
+    std::mt19937 random(user);
+    try
+    {
+        for (int iteration = 0; iteration < config.iterations; ++iteration)
+        {
+            timed("switch to crops", [&app] { app.setInternalPath(internal_path::crops, true); });
+            timed("switch to hothouses", [&app] { app.setInternalPath(internal_path::hothouses, true); });
+
+            const int rows = hothouses_table ? hothouses_table->model()->rowCount() : 0;
+            if (rows == 0)
+            {
+                continue;
+            }
+
+            const int row = std::uniform_int_distribution<int>(0, rows - 1)(random);
+            timed("open works dialog",
+                [hothouses_table, row]
+            {
+                // The action cells carry their own click handlers, so click the cell the
+                // table's delegate draws for the row.
+                const Wt::WModelIndex index = hothouses_table->model()->index(row, hothouses_model::works_column);
+                std::unique_ptr<Wt::WWidget> cell = hothouses_table->itemDelegate(index)->update(
+                    nullptr, index, Wt::WFlags<Wt::ViewItemRenderFlag>());
+                if (auto action = dynamic_cast<Wt::WInteractWidget*>(cell.get()))
+                {
+                    action->clicked().emit(Wt::WMouseEvent());
+                }
+            });
+
+            auto save = find_widget<Wt::WPushButton>(app, object_name::works_save);
+            if (save)
+            {
+                timed("save works", [save] { save->clicked().emit(Wt::WMouseEvent()); });
+            }
+            else if (auto dialog = find_widget<Wt::WDialog>(app, object_name::works_dialog))
+            {
+                dialog->reject();
+            }
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "user " << user << ": " << error.what() << std::endl;
+    }
+
+    results.add(samples);
+}
+
+options parse_options(int argc, char* argv[])
+{
+    options config;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string name = argv[i];
+        const std::string value = argv[i + 1];
+        if (name == "--users")
+        {
+            config.users = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (name == "--iterations")
+        {
+            config.iterations = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (name == "--connections")
+        {
+            config.connections = std::max(1, std::atoi(value.c_str()));
+        }
+        else if (name == "--prefetch-delay")
+        {
+            config.application_settings.prefetch_delay = std::chrono::milliseconds(std::atoi(value.c_str()));
+        }
+        else if (name == "--login")
+        {
+            config.login = value;
+        }
+    }
+    return config;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    const options config = parse_options(argc, argv);
+
+    try
+    {
+        models::session::configure_auth();
+
+        connection_pool::settings pool_settings;
+        if (const char* connection_string = std::getenv("AGROMASTER_DB"))
+        {
+            pool_settings.connection_string = connection_string;
+        }
+        pool_settings.max_connections = config.connections;
+        pool_settings.min_connections = std::min(pool_settings.min_connections, config.connections);
+        connection_pool pool(
+            [connection_string = pool_settings.connection_string]
+        {
+            return std::make_unique<instrumented_connection<Wt::Dbo::backend::Postgres>>(connection_string);
+        },
+            pool_settings);
+        {
+            models::session session(pool);
+            models::migrate(session);
+        }
+        worker_pool password_workers(1, 1);
+
+        gate logged_in(config.users);
+        latencies results;
+        const long resident_before = resident_bytes();
+        const clock_type::time_point started = clock_type::now();
+
+        std::vector<std::thread> users;
+        for (int user = 0; user < config.users; ++user)
+        {
+            users.emplace_back(simulate_user,
+                std::cref(config), user, std::ref(pool), std::ref(password_workers),
+                std::ref(logged_in), std::ref(results));
+        }
+        logged_in.wait_for_all();
+        const long resident_logged_in = resident_bytes();
+        logged_in.open();
+        for (std::thread& user : users)
+        {
+            user.join();
+        }
+        const double seconds = std::chrono::duration<double>(clock_type::now() - started).count();
+
+        std::size_t actions = 0;
+        std::cout << "action                    count     p50_ms     p99_ms" << std::endl;
+        for (const auto& action : results.samples())
+        {
+            actions += action.second.size();
+            std::cout
+                << std::left << std::setw(22) << action.first << std::right
+                << std::setw(9) << action.second.size()
+                << std::fixed << std::setprecision(2)
+                << std::setw(11) << benchmark::percentile(action.second, 0.5)
+                << std::setw(11) << benchmark::percentile(action.second, 0.99)
+                << std::endl;
+        }
+
+        const connection_pool::statistics pool_stats = pool.stats();
+        std::cout
+            << std::setprecision(1)
+            << "\nsessions: " << config.users << ", iterations: " << config.iterations
+            << ", pool connections: " << config.connections << '\n'
+            << "throughput: " << actions / seconds << " actions/s over " << seconds << " s\n";
+        if (resident_before > 0)
+        {
+            std::cout << "memory per session: "
+                << (resident_logged_in - resident_before) / 1024.0 / config.users << " KiB resident\n";
+        }
+        std::cout
+            << "pool: " << pool_stats.checkouts << " checkouts, " << pool_stats.waits << " waited, "
+            << pool_stats.timeouts << " timed out, peak " << pool_stats.peak_in_use << " in use\n"
+            << "pool wait: mean "
+            << (pool_stats.checkouts ? pool_stats.total_wait.count() / 1000.0 / pool_stats.checkouts : 0.0)
+            << " ms, max " << pool_stats.max_wait.count() / 1000.0 << " ms" << std::endl;
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "exception: " << error.what() << std::endl;
+        return 1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+// Latency and statement counts of the hot model and query paths against an in-memory
+// SQLite database seeded with synthetic farms.
+//
+// usage: agromaster_benchmark [--runs N] [hothouse counts...]
+// The default farms have 10, 1000, 10000 and 100000 hothouses.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <sqlite3.h>
+
+#include <Wt/Dbo/FixedSqlConnectionPool.h>
+#include <Wt/Dbo/backend/Sqlite3.h>
+
+#include "models.hpp"
+#include "models/migrations.hpp"
+
+#include "statistics.hpp"
+
+namespace
+{
+
+using namespace agromaster;
+
+constexpr int page_size = 50;
+constexpr int hothouses_per_crop = 50;
+// Rows per seeding insert, below SQLite's default bind parameter limit.
+constexpr int seed_batch_rows = 100;
+
+// Counts every statement SQLite starts on the connection, including the transaction
+// statements Wt::Dbo issues around each operation.
+struct statement_counter
+{
+    std::uint64_t statements = 0;
+
+    static int trace(unsigned, void* context, void*, void*)
+    {
+        ++static_cast<statement_counter*>(context)->statements;
+        return 0;
+    }
+};
+
+struct farm
+{
+    // On the heap, so the address given to the trace hook survives moves of the farm;
+    // declared first, so it outlives the connection it counts.
+    std::unique_ptr<statement_counter> counter = std::make_unique<statement_counter>();
+    std::unique_ptr<Wt::Dbo::SqlConnectionPool> pool;
+    int hothouses = 0;
+    int crops = 0;
+};
+
+std::string season_dates(int hothouse)
+{
+    std::set<Wt::WDate> dates;
+    const Wt::WDate first(2024, 4, 1 + hothouse % 28);
+    for (int day = 0; day < 180; day += 1 + hothouse % 3)
+    {
+        dates.insert(first.addDays(day));
+    }
+    return models::encode_dates(dates);
+}
+
+void seed(models::session& session, int hothouses, int crops)
+{
+    Wt::Dbo::Transaction transaction(session);
+    for (int crop = 1; crop <= crops; ++crop)
+    {
+        session.execute("insert into crop (version, title) values (0, ?)").bind("crop " + std::to_string(crop)).run();
+        session.execute(
+            "insert into schedules (version, sowing_schedule, harvest_schedule, fertilizer_dates, watering_dates, crop_id) "
+            "values (0, ?, ?, ?, ?, ?)")
+            .bind(Wt::WDate(2024, 4, 1)).bind(Wt::WDate(2024, 9, 30))
+            .bind(season_dates(crop)).bind(season_dates(crop + 1))
+            .bind(crop)
+            .run();
+    }
+
+    for (int first = 1; first <= hothouses; first += seed_batch_rows)
+    {
+        const int last = std::min(hothouses, first + seed_batch_rows - 1);
+        std::string hothouse_values;
+        std::string works_values;
+        for (int id = first; id <= last; ++id)
+        {
+            hothouse_values += id == first ? "(?, 0, ?, ?, ?, nullif(?, 0))" : ", (?, 0, ?, ?, ?, nullif(?, 0))";
+            works_values += id == first ? "(0, ?, ?, ?, ?, ?)" : ", (0, ?, ?, ?, ?, ?)";
+        }
+
+        Wt::Dbo::Call insert_hothouses = session.execute(
+            "insert into hothouse (id, version, title, yields, spent_fertilizers, crop_id) values " + hothouse_values);
+        Wt::Dbo::Call insert_works = session.execute(
+            "insert into works (version, sowing_work, harvest_work, fertilizer_dates, watering_dates, hothouse_id) values "
+            + works_values);
+        for (int id = first; id <= last; ++id)
+        {
+            // Every tenth hothouse has no crop.
+            insert_hothouses.bind(id).bind("hothouse " + std::to_string(id)).bind(id % 997 * 1.5).bind(id % 101 * 0.5)
+                .bind(id % 10 == 0 ? 0 : id % crops + 1);
+            insert_works.bind(Wt::WDate(2024, 4, 10)).bind(Wt::WDate(2024, 9, 20))
+                .bind(season_dates(id)).bind(season_dates(id + 7)).bind(id);
+        }
+        insert_hothouses.run();
+        insert_works.run();
+    }
+}
+
+farm create_farm(int hothouses)
+{
+    farm result;
+    result.hothouses = hothouses;
+    result.crops = std::max(1, hothouses / hothouses_per_crop);
+
+    auto connection = std::make_unique<Wt::Dbo::backend::Sqlite3>(":memory:");
+    sqlite3_trace_v2(connection->connection(), SQLITE_TRACE_STMT, &statement_counter::trace, result.counter.get());
+    // A single connection: every clone of ":memory:" would be a separate empty database.
+    result.pool = std::make_unique<Wt::Dbo::FixedSqlConnectionPool>(std::move(connection), 1);
+
+    models::session session(*result.pool);
+    models::migrate(session);
+    seed(session, result.hothouses, result.crops);
+    return result;
+}
+
+struct measurement
+{
+    std::vector<double> microseconds;
+    std::uint64_t statements = 0;
+};
+
+measurement measure(farm& farm, int runs, const std::function<void(int)>& operation)
+{
+    measurement result;
+    result.microseconds.reserve(runs);
+    const std::uint64_t statements_before = farm.counter->statements;
+    for (int run = 0; run < runs; ++run)
+    {
+        const auto started = std::chrono::steady_clock::now();
+        operation(run);
+        const auto elapsed = std::chrono::steady_clock::now() - started;
+        result.microseconds.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+    }
+    result.statements = farm.counter->statements - statements_before;
+    return result;
+}
+
+void report(int hothouses, const std::string& operation, const measurement& result)
+{
+    const std::size_t runs = result.microseconds.size();
+    double total = 0.0;
+    for (double microseconds : result.microseconds)
+    {
+        total += microseconds;
+    }
+    std::cout
+        << std::setw(9) << hothouses << "  "
+        << std::left << std::setw(22) << operation << std::right
+        << std::setw(6) << runs
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << total / runs
+        << std::setw(12) << benchmark::percentile(result.microseconds, 0.5)
+        << std::setw(12) << benchmark::percentile(result.microseconds, 0.99)
+        << std::setw(14) << static_cast<double>(result.statements) / runs
+        << std::endl;
+}
+
+void run_farm(int hothouses, int runs)
+{
+    farm farm = create_farm(hothouses);
+    std::mt19937 random(hothouses);
+    std::uniform_int_distribution<long long> hothouse_ids(1, hothouses);
+    const int pages = (hothouses + page_size - 1) / page_size;
+
+    // A fresh session per operation keeps the Dbo object cache from hiding the queries.
+    report(hothouses, "hothouse page (keyset)", measure(farm, runs,
+        [&](int run)
+    {
+        models::session session(*farm.pool);
+        Wt::Dbo::Transaction transaction(session);
+        session.hothouse_summaries_after(static_cast<long long>(run % pages) * page_size, page_size);
+    }));
+
+    report(hothouses, "hothouse page (offset)", measure(farm, runs,
+        [&](int run)
+    {
+        models::session session(*farm.pool);
+        Wt::Dbo::Transaction transaction(session);
+        session.hothouse_summaries_from(run % pages * page_size, page_size);
+    }));
+
+    report(hothouses, "hothouses count", measure(farm, runs,
+        [&](int)
+    {
+        models::session session(*farm.pool);
+        Wt::Dbo::Transaction transaction(session);
+        session.hothouses_count();
+    }));
+
+    report(hothouses, "crop aggregates", measure(farm, runs,
+        [&](int)
+    {
+        models::session session(*farm.pool);
+        Wt::Dbo::Transaction transaction(session);
+        session.crop_summaries();
+    }));
+
+    report(hothouses, "works dialog load", measure(farm, runs,
+        [&](int)
+    {
+        models::session session(*farm.pool);
+        Wt::Dbo::Transaction transaction(session);
+        models::season_dates works;
+        session.hothouse_works(hothouse_ids(random), works);
+    }));
+
+    report(hothouses, "works save", measure(farm, runs,
+        [&](int run)
+    {
+        models::session session(*farm.pool);
+        Wt::Dbo::Transaction transaction(session);
+        Wt::Dbo::ptr<models::hothouse> hothouse = session.load<models::hothouse>(hothouse_ids(random));
+        Wt::Dbo::ptr<models::works> works = hothouse->works.lock();
+        std::set<Wt::WDate> dates = models::decode_dates(works->watering_dates);
+        dates.insert(Wt::WDate(2024, 10, 1).addDays(run % 30));
+        works.modify()->watering_dates = models::encode_dates(dates);
+    }));
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    int runs = 200;
+    std::vector<int> farms;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument == "--runs" && i + 1 < argc)
+        {
+            runs = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            farms.push_back(std::max(1, std::atoi(argv[i])));
+        }
+    }
+    if (farms.empty())
+    {
+        farms = { 10, 1000, 10000, 100000 };
+    }
+
+    try
+    {
+        models::session::configure_auth();
+
+        std::cout
+            << "hothouses  operation               runs     mean_us      p50_us      p99_us  statements/op"
+            << std::endl;
+        for (int hothouses : farms)
+        {
+            run_farm(hothouses, runs);
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "exception: " << error.what() << std::endl;
+        return 1;
+    }
+}
\ No newline at end of file
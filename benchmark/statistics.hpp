@@ -0,0 +1,29 @@
+#pragma once
+#ifndef AGROMASTER_BENCHMARK_STATISTICS_HPP_
+#define AGROMASTER_BENCHMARK_STATISTICS_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace agromaster
+{
+namespace benchmark
+{
+
+// Nearest-rank percentile, fraction in [0, 1]; 0 when there are no values.
+inline double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const std::size_t index = std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()));
+    return values[index];
+}
+
+} // benchmark
+} // agromaster
+
+#endif // AGROMASTER_BENCHMARK_STATISTICS_HPP_
\ No newline at end of file
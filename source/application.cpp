@@ -1,13 +1,18 @@
 #include "application.hpp"
 
-#include <numeric>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 
 #include <Wt/Auth/PasswordService.h>
+#include <Wt/WAnchor.h>
 #include <Wt/WBootstrap5Theme.h>
 #include <Wt/WBreak.h>
 #include <Wt/WCalendar.h>
 #include <Wt/WDateEdit.h>
+#include <Wt/WDialog.h>
 #include <Wt/WDoubleValidator.h>
+#include <Wt/WFileUpload.h>
 #include <Wt/WLabel.h>
 #include <Wt/WLineEdit.h>
 #include <Wt/WMenu.h>
@@ -15,56 +20,223 @@
 #include <Wt/WRegExpValidator.h>
 #include <Wt/WSelectionBox.h>
 #include <Wt/WTable.h>
-#include <Wt/WTableCell.h>
+#include <Wt/WTableView.h>
+#include <Wt/WTimer.h>
+
+#include "async_auth_widget.hpp"
+#include "catalog_import.hpp"
+#include "catalog_cache.hpp"
+#include "change_bus.hpp"
+#include "configuration.hpp"
+#include "connection_pool.hpp"
+#include "crops_model.hpp"
+#include "export_resource.hpp"
+#include "metrics.hpp"
+#include "record_action_delegate.hpp"
+
+namespace
+{
+
+// Id of the crop picked in a dialog selection box, 0 for the leading "not selected" item.
+long long selected_crop_id(const Wt::WSelectionBox& selection, const std::vector<long long>& crop_ids)
+{
+    const int index = selection.currentIndex();
+    return index > 0 ? crop_ids[index] : 0;
+}
+
+// Widgets reachable from widget through containers, tables and dialogs. Composite widgets
+// such as the table views count as one, whatever they render.
+std::size_t count_widgets(Wt::WWidget* widget)
+{
+    if (!widget)
+    {
+        return 0;
+    }
+
+    std::size_t count = 1;
+    if (auto container = dynamic_cast<Wt::WContainerWidget*>(widget))
+    {
+        for (int i = 0; i < container->count(); ++i)
+        {
+            count += count_widgets(container->widget(i));
+        }
+    }
+    else if (auto table = dynamic_cast<Wt::WTable*>(widget))
+    {
+        for (int row = 0; row < table->rowCount(); ++row)
+        {
+            for (int column = 0; column < table->columnCount(); ++column)
+            {
+                count += count_widgets(table->elementAt(row, column));
+            }
+        }
+    }
+    else if (auto dialog = dynamic_cast<Wt::WDialog*>(widget))
+    {
+        count += count_widgets(dialog->titleBar()) + count_widgets(dialog->contents()) + count_widgets(dialog->footer());
+    }
+    return count;
+}
+
+} // unnamed namespace
 
 namespace agromaster
 {
 
-application::application(const Wt::WEnvironment& env, Wt::Dbo::SqlConnectionPool& connection_pool)
+constexpr std::chrono::seconds application::footprint_interval;
+
+application::settings application::settings::load(const Wt::WServer& server)
+{
+    settings config;
+    configuration::read_duration(server, "AGROMASTER_PREFETCH_DELAY", "agromaster-prefetch-delay",
+        config.prefetch_delay);
+    return config;
+}
+
+application::application(
+    const Wt::WEnvironment& env,
+    Wt::Dbo::SqlConnectionPool& connection_pool,
+    worker_pool& password_workers,
+    const settings& config)
     : Wt::WApplication(env)
+    , settings_(config)
+    , session_key_(sessionId())
+    , bus_session_id_(sessionId())
+    , connection_pool_(connection_pool)
     , db_session_(connection_pool)
+    , repository_(db_session_)
+    , password_workers_(password_workers)
 {
     setTitle("AgroMaster");
     setTheme(std::make_shared<Wt::WBootstrap5Theme>());
+    enableUpdates(true);
 
     db_session_.login().changed().connect(this, &application::handle_auth);
     internalPathChanged().connect(this, &application::handle_path_changes);
+    metrics::instance().session_started();
+    change_bus::instance().subscribe(session_key_, bus_session_id_,
+        [this](const change_set& changes)
+    {
+        handle_published_changes(changes);
+    });
     set_auth_widget();
     setInternalPath(internal_path::root);
 }
 
+application::~application()
+{
+    change_bus::instance().unsubscribe(session_key_);
+    metrics::instance().session_ended(session_key_);
+}
+
+void application::notify(const Wt::WEvent& event)
+{
+    const auto started = std::chrono::steady_clock::now();
+    try
+    {
+        const connection_pool::admission admission(connection_pool::priority::read);
+        Wt::WApplication::notify(event);
+    }
+    catch (const connection_pool::overloaded& error)
+    {
+        // The transaction of the handler was rolled back; the session carries on degraded.
+        log("warning") << "Request dropped: " << error.what();
+        show_error(u8"<p> ,     .</p>");
+    }
+    // Logging in changes the session id; deltas posted to the old one would be dropped.
+    if (sessionId() != bus_session_id_)
+    {
+        bus_session_id_ = sessionId();
+        change_bus::instance().move_session(session_key_, bus_session_id_);
+    }
+    const auto finished = std::chrono::steady_clock::now();
+    metrics::instance().observe_request(finished - started);
+    if (finished - footprint_measured_ >= footprint_interval)
+    {
+        footprint_measured_ = finished;
+        account_memory();
+    }
+}
+
+void application::account_memory()
+{
+    metrics::session_footprint footprint;
+    footprint.widgets = count_widgets(root());
+    footprint.model_bytes = hothouses_model_ ? hothouses_model_->memory_bytes() : 0;
+    metrics::instance().observe_session_footprint(session_key_, footprint);
+}
+
 void application::handle_path_changes()
 {
-    if (internalPathMatches(internal_path::hothouses))
+    const metrics::handler_scope scope("handle_path_changes");
+    if (main_stack_ && internalPathMatches(internal_path::hothouses))
     {
+        if (!hothouses_)
+        {
+            set_hothouses_table();
+            schedule_prefetch();
+        }
         main_stack_->setCurrentWidget(hothouses_);
     }
-    else if (internalPathMatches(internal_path::crops))
+    else if (main_stack_ && internalPathMatches(internal_path::crops))
     {
+        if (!crops_)
+        {
+            set_crops_table();
+            schedule_prefetch();
+        }
         main_stack_->setCurrentWidget(crops_);
     }
     else if (db_session_.login().loggedIn())
     {
-        setInternalPath(internal_path::hothouses);
+        setInternalPath(internal_path::hothouses, true);
     }
     else
     {
-        if (!navigation_->isHidden())
+        if (navigation_ && !navigation_->isHidden())
         {
             navigation_->hide();
         }
-        if (!main_stack_->isHidden())
+        if (main_stack_ && !main_stack_->isHidden())
         {
             main_stack_->hide();
         }
-        if (main_stack_->isHidden())
-        {
-            auth_widget_->show();
-        }
+        auth_widget_->show();
         setInternalPath(internal_path::root);
     }
 }
 
+void application::schedule_prefetch()
+{
+    if (settings_.prefetch_delay < std::chrono::milliseconds::zero() || (hothouses_ && crops_))
+    {
+        return;
+    }
+
+    // The timer runs on the client, so it fires only once the current page has arrived.
+    Wt::WTimer::singleShot(settings_.prefetch_delay, this, &application::prefetch_pages);
+}
+
+void application::prefetch_pages()
+{
+    const metrics::handler_scope scope("prefetch_pages");
+    if (!main_stack_)
+    {
+        return;
+    }
+
+    Wt::WWidget* current = main_stack_->currentWidget();
+    if (!hothouses_)
+    {
+        set_hothouses_table();
+    }
+    if (!crops_)
+    {
+        set_crops_table();
+    }
+    main_stack_->setCurrentWidget(current);
+}
+
 void application::set_navigation_bar(const Wt::WString& login_name)
 {
     navigation_ = root()->addNew<Wt::WNavigationBar>();
@@ -95,103 +267,102 @@ void application::set_navigation_bar(const Wt::WString& login_name)
     navigation_->addWidget(std::move(logout_button));
 }
 
-void application::add_hothouse_row(Wt::WTable& table, int index, const agromaster::models::hothouse& hothouse)
-{
-    constexpr char style_class[] = "text-center";
-    auto hothouse_title = table.elementAt(index, 0)->addNew<Wt::WText>(hothouse.title);
-    table.elementAt(index, 0)->setStyleClass(style_class);
-    auto crop_title = table.elementAt(index, 1)->addNew<Wt::WText>(hothouse.crop ? hothouse.crop->title : u8" ");
-    table.elementAt(index, 1)->setStyleClass(style_class);
-    auto yields = table.elementAt(index, 2)->addNew<Wt::WText>(std::to_string(hothouse.yields));
-    table.elementAt(index, 2)->setStyleClass(style_class);
-    auto spent_fertilizers = table.elementAt(index, 3)->addNew<Wt::WText>(std::to_string(hothouse.spent_fertilizers));
-    table.elementAt(index, 3)->setStyleClass(style_class);
-    table.elementAt(index, 4)->addNew<Wt::WPushButton>(u8"")->
-        clicked().connect(
-            [this, hothouse_title]()
-    {
-        show_dialog_hothouse_works(hothouse_title);
-    });
-    table.elementAt(index, 4)->setStyleClass(style_class);
-    if (user_role_ == agromaster::models::user_account::role::admin)
-    {
-        table.elementAt(index, 5)->addNew<Wt::WPushButton>(u8"")->
-            clicked().connect(
-                [this, hothouse_title, crop_title, yields, spent_fertilizers]()
-        {
-            show_dialog_change_hothouse(hothouse_title, crop_title, yields, spent_fertilizers);
-        });
-        table.elementAt(index, 5)->setStyleClass(style_class);
-        table.elementAt(index, 6)->addNew<Wt::WPushButton>(u8"")->
-            clicked().connect(
-                [this, row = table.rowAt(index), hothouse_title]()
-        {
-            handle_delete_hothouse(row, hothouse_title->text());
-        });
-        table.elementAt(index, 6)->setStyleClass(style_class);
-    }
-}
-
 void application::set_hothouses_table()
 {
+    const metrics::handler_scope scope("set_hothouses_table");
     hothouses_ = main_stack_->addNew<Wt::WContainerWidget>();
-    
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::collection<Wt::Dbo::ptr<models::hothouse>> hothouses = db_session_.find<models::hothouse>();
 
     if (user_role_ == models::user_account::role::admin)
     {
         auto add_new_hothouse_button = hothouses_->addNew<Wt::WPushButton>(u8"");
         add_new_hothouse_button->setStyleClass("m-3");
         add_new_hothouse_button->clicked().connect(this, &application::show_dialog_add_hothouse);
-    }
 
-    auto hothouses_table = hothouses_->addNew<Wt::WTable>();
-    hothouses_table->addStyleClass("table table-striped");
-    hothouses_table->setWidth("100%");
-    int i = 0;
+        auto import_button = hothouses_->addNew<Wt::WPushButton>(u8"  CSV");
+        import_button->setStyleClass("m-3");
+        import_button->clicked().connect(this, &application::show_dialog_import);
+    }
 
-    hothouses_table->setHeaderCount(1);
-    hothouses_table->elementAt(i, 0)->addNew<Wt::WText>(u8"");
-    hothouses_table->elementAt(i, 1)->addNew<Wt::WText>(u8"");
-    hothouses_table->elementAt(i, 2)->addNew<Wt::WText>(u8", ");
-    hothouses_table->elementAt(i, 3)->addNew<Wt::WText>(u8" , ");
-    if (user_role_ == agromaster::models::user_account::role::admin)
-    {
-        hothouses_table->elementAt(i, 4)->addNew<Wt::WText>("");
-        hothouses_table->elementAt(i, 5)->addNew<Wt::WText>("");
+    auto export_link = hothouses_->addNew<Wt::WAnchor>(
+        Wt::WLink(std::make_shared<export_resource>(connection_pool_, export_resource::table::hothouses)),
+        u8"  CSV");
+    export_link->setStyleClass("btn btn-outline-success m-3");
+
+    hothouses_model_ = std::make_shared<hothouses_model>(
+        repository_, user_role_ == models::user_account::role::admin);
+
+    auto hothouses_table = hothouses_->addNew<Wt::WTableView>();
+    hothouses_table->setObjectName(object_name::hothouses_table);
+    hothouses_table->setModel(hothouses_model_);
+    hothouses_table->setAlternatingRowColors(true);
+    hothouses_table->setSelectionMode(Wt::SelectionMode::None);
+    hothouses_table->setSortingEnabled(false);
+    hothouses_table->setHeaderHeight(40);
+    hothouses_table->setRowHeight(40);
+    hothouses_table->setHeight(600);
+    for (int column = 0; column < hothouses_model_->columnCount(); ++column)
+    {
+        hothouses_table->setColumnWidth(column, column < hothouses_model::works_column ? 220 : 110);
     }
 
-    ++i;
-    for (const Wt::Dbo::ptr<models::hothouse> hothouse : hothouses)
+    // Clicks resolve to the id drawn in the cell, not to whatever row now sits under it.
+    auto actions = std::make_shared<record_action_delegate>(
+        [this](int column, long long hothouse_id) { handle_hothouse_action(column, hothouse_id); });
+    for (int column = hothouses_model::works_column; column < hothouses_model_->columnCount(); ++column)
     {
-        add_hothouse_row(*hothouses_table, i, *hothouse);
-        ++i;
+        hothouses_table->setItemDelegateForColumn(column, actions);
     }
 }
 
-void application::update_hothouses_table()
+void application::handle_hothouse_action(int column, long long hothouse_id)
 {
-    main_stack_->removeWidget(hothouses_);
-    set_hothouses_table();
+    if (column == hothouses_model::works_column)
+    {
+        show_dialog_hothouse_works(hothouse_id);
+        return;
+    }
+
+    const std::vector<models::hothouse_summary> hothouses = repository_.hothouses({hothouse_id});
+    if (hothouses.empty())
+    {
+        check_outcome(catalog_repository::outcome::not_found, {});
+        return;
+    }
+
+    const models::hothouse_summary& hothouse = hothouses.front();
+    switch (column)
+    {
+    case hothouses_model::change_column:
+        show_dialog_change_hothouse(hothouse);
+        break;
+    case hothouses_model::delete_column:
+        confirm_delete(
+            Wt::WString(u8"  {1}?").arg(Wt::WString::fromUTF8(hothouse.title)),
+            [this, hothouse_id] { handle_delete_hothouse(hothouse_id); });
+        break;
+    default:
+        break;
+    }
 }
 
 void application::show_dialog_add_hothouse()
 {
+    const metrics::handler_scope scope("show_dialog_add_hothouse");
     auto dialog = root()->addNew<Wt::WDialog>(u8"  ");
 
     Wt::WLabel* label_hothouse_name = dialog->contents()->addNew<Wt::WLabel>(u8"");
     Wt::WLineEdit* edit = dialog->contents()->addNew<Wt::WLineEdit>();
     label_hothouse_name->setBuddy(edit);
 
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::collection<Wt::Dbo::ptr<models::crop>> crops = db_session_.find<models::crop>();
+    catalog_cache::crops_type crops = repository_.crops();
     Wt::WLabel* label_crop_name = dialog->contents()->addNew<Wt::WLabel>(u8"");
     Wt::WSelectionBox* selection = dialog->contents()->addNew<Wt::WSelectionBox>();
     selection->addItem(u8" ");
-    for (const Wt::Dbo::ptr<models::crop>& crop : crops)
+    std::vector<long long> crop_ids{0};
+    for (const models::crop_summary& crop : *crops)
     {
-        selection->addItem(crop->title);
+        selection->addItem(crop.title);
+        crop_ids.push_back(crop.id);
     }
     selection->setCurrentIndex(0);
     label_crop_name->setBuddy(selection);
@@ -230,11 +401,11 @@ void application::show_dialog_add_hothouse()
     cancel->clicked().connect(dialog, &Wt::WDialog::reject);
 
     dialog->finished().connect(
-        [this, dialog, edit, selection]
+        [this, dialog, edit, selection, crop_ids]
     {
         if (dialog->result() == Wt::DialogCode::Accepted)
         {
-            handle_add_hothouse(edit->text().toUTF8(), selection->currentText().toUTF8());
+            handle_add_hothouse(edit->text().toUTF8(), selected_crop_id(*selection, crop_ids));
         }
         root()->removeChild(dialog);
     });
@@ -242,93 +413,50 @@ void application::show_dialog_add_hothouse()
     dialog->show();
 }
 
-void application::handle_add_hothouse(const std::string& title, const std::string& crop_title)
+void application::handle_add_hothouse(const std::string& title, long long crop_id)
 {
-
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::ptr<models::hothouse> existing_hothouse =
-        db_session_.find<models::hothouse>().where("title = ?").bind(title).limit(1);
-    if (existing_hothouse)
-    {
-        auto message_box =
-            root()->addChild(std::make_unique<Wt::WMessageBox>(
-                u8"",
-                u8"<p>     !</p>",
-                Wt::Icon::Critical,
-                Wt::StandardButton::Ok));
-
-        message_box->setModal(true);
-        message_box->buttonClicked().connect([this, message_box] { root()->removeChild(message_box); });
-        message_box->show();
-    }
-    else
+    const metrics::handler_scope scope("handle_add_hothouse");
+    change_set changes;
+    if (check_outcome(repository_.add_hothouse(title, crop_id, changes),
+        u8"<p>     !</p>"))
     {
-        auto new_hothouse = db_session_.addNew<models::hothouse>();
-        new_hothouse.modify()->title = title;
-        new_hothouse.modify()->works = db_session_.addNew<models::works>();
-        Wt::Dbo::ptr<models::crop> selected_crop;
-        if (crop_title != u8" ")
-        {
-            selected_crop = db_session_.find<models::crop>().where("title = ?").bind(crop_title);
-        }
-        if (selected_crop)
-        {
-            new_hothouse.modify()->crop = selected_crop;
-            selected_crop.modify()->hothouses.insert(new_hothouse);
-        }
-
-        try
-        {
-            constexpr int table_index = 1;
-            Wt::WTable& hothouses_table(dynamic_cast<Wt::WTable&>(*hothouses_->widget(table_index)));
-            add_hothouse_row(hothouses_table, hothouses_table.rowCount(), *new_hothouse);
-            update_crops_table();
-        }
-        catch (const std::bad_cast& error)
-        {
-            log("error") << error.what();
-        }
+        publish_changes(changes);
     }
 }
 
-void application::show_dialog_change_hothouse(
-    Wt::WText* current_title,
-    Wt::WText* current_crop_title,
-    Wt::WText* current_yields,
-    Wt::WText* current_spent_fertilizers)
+void application::show_dialog_change_hothouse(const models::hothouse_summary& hothouse)
 {
+    const metrics::handler_scope scope("show_dialog_change_hothouse");
     auto dialog = root()->addNew<Wt::WDialog>(u8" ");
 
     auto* label_new_hothouse_name = dialog->contents()->addNew<Wt::WLabel>(u8" ");
     auto* edit_hothouse_name = dialog->contents()->addNew<Wt::WLineEdit>();
-    edit_hothouse_name->setText(current_title->text());
+    edit_hothouse_name->setText(hothouse.title);
     label_new_hothouse_name->setBuddy(edit_hothouse_name);
 
     auto* label_yields = dialog->contents()->addNew<Wt::WLabel>(u8" ");
     auto* edit_yields = dialog->contents()->addNew<Wt::WLineEdit>();
-    edit_yields->setText(current_yields->text());
+    edit_yields->setText(std::to_string(hothouse.yields));
     label_new_hothouse_name->setBuddy(edit_yields);
 
     auto* label_spent_fertilizers = dialog->contents()->addNew<Wt::WLabel>(u8"  ");
     auto* edit_spent_fertilizers = dialog->contents()->addNew<Wt::WLineEdit>();
-    edit_spent_fertilizers->setText(current_spent_fertilizers->text());
+    edit_spent_fertilizers->setText(std::to_string(hothouse.spent_fertilizers));
     label_new_hothouse_name->setBuddy(edit_spent_fertilizers);
 
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::collection<Wt::Dbo::ptr<models::crop>> crops = db_session_.find<models::crop>();
+    catalog_cache::crops_type crops = repository_.crops();
     auto* label_crop_name = dialog->contents()->addNew<Wt::WLabel>(u8"");
     auto* selection = dialog->contents()->addNew<Wt::WSelectionBox>();
     selection->addItem(u8" ");
-    std::size_t i = 0;
-    selection->setCurrentIndex(i);
-    std::string current_crop_title_string = current_crop_title->text().toUTF8();
-    for (const Wt::Dbo::ptr<models::crop>& crop : crops)
-    {
-        selection->addItem(crop->title);
-        ++i;
-        if (crop->title == current_crop_title_string)
+    selection->setCurrentIndex(0);
+    std::vector<long long> crop_ids{0};
+    for (const models::crop_summary& crop : *crops)
+    {
+        selection->addItem(crop.title);
+        crop_ids.push_back(crop.id);
+        if (crop.id == hothouse.crop_id)
         {
-            selection->setCurrentIndex(i);
+            selection->setCurrentIndex(static_cast<int>(crop_ids.size() - 1));
         }
     }
     label_crop_name->setBuddy(selection);
@@ -382,20 +510,17 @@ void application::show_dialog_change_hothouse(
 
     dialog->finished().connect(
         [this, dialog,
-        edit_hothouse_name, edit_yields, edit_spent_fertilizers, selection,
-        current_title, current_crop_title, current_yields, current_spent_fertilizers]
+        edit_hothouse_name, edit_yields, edit_spent_fertilizers, selection, crop_ids,
+        hothouse_id = hothouse.id]
     {
         if (dialog->result() == Wt::DialogCode::Accepted)
         {
             handle_change_hothouse(
+                hothouse_id,
                 edit_hothouse_name->text().toUTF8(),
-                selection->currentText().toUTF8(),
-                edit_yields->text().toUTF8(),
-                edit_spent_fertilizers->text().toUTF8(),
-                current_title,
-                current_crop_title,
-                current_yields,
-                current_spent_fertilizers);
+                selected_crop_id(*selection, crop_ids),
+                std::stod(edit_yields->text().toUTF8()),
+                std::stod(edit_spent_fertilizers->text().toUTF8()));
         }
         root()->removeChild(dialog);
     });
@@ -404,84 +529,138 @@ void application::show_dialog_change_hothouse(
 }
 
 void application::handle_change_hothouse(
+    long long hothouse_id,
     const std::string& new_title,
-    const std::string& new_crop,
-    const std::string& new_yields,
-    const std::string& new_spent_fertilizers,
-    Wt::WText* current_title,
-    Wt::WText* current_crop_title,
-    Wt::WText* current_yields,
-    Wt::WText* current_spent_fertilizers)
+    long long new_crop_id,
+    double new_yields,
+    double new_spent_fertilizers)
 {
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::ptr<models::hothouse> hothouse =
-        db_session_.find<models::hothouse>().where("title = ?").bind(current_title->text()).limit(1);
-
-    if (!new_title.empty() && hothouse->title != new_title)
+    const metrics::handler_scope scope("handle_change_hothouse");
+    change_set changes;
+    if (check_outcome(
+        repository_.change_hothouse(hothouse_id, new_title, new_crop_id, new_yields, new_spent_fertilizers, changes),
+        u8"<p>     !</p>"))
     {
-        hothouse.modify()->title = new_title;
-        current_title->setText(new_title);
+        publish_changes(changes);
     }
+}
+
+void application::show_dialog_import()
+{
+    const metrics::handler_scope scope("show_dialog_import");
+    auto dialog = root()->addNew<Wt::WDialog>(u8"  CSV");
+
+    dialog->contents()->addNew<Wt::WText>(
+        u8"<p>: title, sowing, harvest, fertilizer_dates, watering_dates.</p>"
+        u8"<p>: title, crop, yields, spent_fertilizers, sowing, harvest, fertilizer_dates, watering_dates.</p>"
+        u8"<p>   yyyy-MM-dd,    ;.</p>");
+    auto* upload = dialog->contents()->addNew<Wt::WFileUpload>();
+    upload->setMultiple(true);
+    upload->setFilters(".csv");
+
+    Wt::WPushButton* ok = dialog->footer()->addNew<Wt::WPushButton>(u8"");
+    ok->addStyleClass("btn-success");
+    Wt::WPushButton* cancel = dialog->footer()->addNew<Wt::WPushButton>(u8"");
+    dialog->rejectWhenEscapePressed();
 
-    double new_yields_double = std::stod(new_yields);
-    if (hothouse->yields != new_yields_double)
+    ok->clicked().connect(
+        [ok, upload]
     {
-        hothouse.modify()->yields = new_yields_double;
-        current_yields->setText(new_yields);
-    }
+        if (upload->empty())
+        {
+            return;
+        }
+        ok->disable();
+        upload->upload();
+    });
+    upload->uploaded().connect(dialog, &Wt::WDialog::accept);
+    upload->fileTooLarge().connect(
+        [this, dialog]
+    {
+        dialog->reject();
+        show_error(u8"<p>  !</p>");
+    });
+    cancel->clicked().connect(dialog, &Wt::WDialog::reject);
 
-    double new_spent_fertilizers_double = std::stod(new_spent_fertilizers);
-    if (hothouse->spent_fertilizers != new_spent_fertilizers_double)
+    dialog->finished().connect(
+        [this, dialog, upload]
     {
-        hothouse.modify()->spent_fertilizers = new_spent_fertilizers_double;
-        current_spent_fertilizers->setText(new_spent_fertilizers);
+        if (dialog->result() == Wt::DialogCode::Accepted)
+        {
+            handle_import(upload->uploadedFiles());
+        }
+        root()->removeChild(dialog);
+    });
+
+    dialog->show();
+}
+
+void application::handle_import(const std::vector<Wt::Http::UploadedFile>& files)
+{
+    const metrics::handler_scope scope("handle_import");
+    if (user_role_ != models::user_account::role::admin)
+    {
+        return;
     }
 
-    if (!hothouse->crop && new_crop != u8" ")
+    catalog_import import;
+    for (const Wt::Http::UploadedFile& file : files)
     {
-        Wt::Dbo::ptr<models::crop> selected_crop =
-            db_session_.find<models::crop>().where("title = ?").bind(new_crop);
-        hothouse.modify()->crop = selected_crop;
-        selected_crop.modify()->hothouses.insert(hothouse);
-        current_crop_title->setText(new_crop);
+        std::ifstream in(file.spoolFileName(), std::ios::binary);
+        import.read(in, file.clientFileName());
     }
-    else if (hothouse->crop && new_crop != hothouse->crop->title)
+    const catalog_import::report report = repository_.import_catalog(import);
+
+    if (report.error_count > 0)
     {
-        if (new_crop == u8" ")
+        Wt::WString message = Wt::WString(u8"<p>  , : {1}</p><ul>")
+            .arg(static_cast<int>(report.error_count));
+        for (const catalog_import::error& error : report.errors)
         {
-            hothouse->crop.modify()->hothouses.erase(hothouse);
-            hothouse.modify()->crop = nullptr;
-            current_crop_title->setText(u8" ");
-        }
-        else
-        {
-            Wt::Dbo::ptr<models::crop> selected_crop =
-                db_session_.find<models::crop>().where("title = ?").bind(new_crop);
-            hothouse->crop.modify()->hothouses.erase(hothouse);
-            hothouse.modify()->crop = selected_crop;
-            selected_crop.modify()->hothouses.insert(hothouse);
-            current_crop_title->setText(new_crop);
+            Wt::WString where = Wt::WString::fromUTF8(error.source);
+            if (error.line > 0)
+            {
+                where += Wt::WString(u8",  {1}").arg(static_cast<int>(error.line));
+            }
+            message += "<li>" + Wt::WWebWidget::escapeText(where) + ": " + Wt::WWebWidget::escapeText(error.message) + "</li>";
         }
+        message += "</ul>";
+        show_error(message);
+        return;
     }
-    update_crops_table();
+
+    publish_changes(report.changes);
+    auto message_box =
+        root()->addChild(std::make_unique<Wt::WMessageBox>(
+            u8"",
+            Wt::WString(u8"<p> : {1}, : {2}</p>")
+                .arg(static_cast<int>(report.crops))
+                .arg(static_cast<int>(report.hothouses)),
+            Wt::Icon::Information,
+            Wt::StandardButton::Ok));
+    message_box->setModal(true);
+    message_box->buttonClicked().connect([this, message_box] { root()->removeChild(message_box); });
+    message_box->show();
 }
 
-void application::show_dialog_hothouse_works(Wt::WText* title)
+void application::show_dialog_hothouse_works(long long hothouse_id)
 {
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::ptr<models::hothouse> hothouse =
-        db_session_.find<models::hothouse>().where("title = ?").bind(title->text()).limit(1);
-
-    Wt::Dbo::ptr<models::works> works = hothouse->works.lock();
-    assert(works);
+    const metrics::handler_scope scope("show_dialog_hothouse_works");
+    models::season_dates works;
+    if (!repository_.hothouse_works(hothouse_id, works))
+    {
+        check_outcome(catalog_repository::outcome::not_found, {});
+        return;
+    }
 
     auto dialog = root()->addNew<Wt::WDialog>(u8" ");
+    dialog->setObjectName(object_name::works_dialog);
     dialog->setScrollVisibilityEnabled(true);
     dialog->setMaximumSize("90%", "90%");
     
     auto* sowing_date_label = dialog->contents()->addNew<Wt::WLabel>(u8"");
     auto* sowing_date_edit = dialog->contents()->addNew<Wt::WDateEdit>();
-    sowing_date_edit->setDate(works->sowing_work);
+    sowing_date_edit->setDate(works.sowing);
     if (user_role_ == models::user_account::role::admin)
     {
         sowing_date_edit->setSelectable(true);
@@ -496,7 +675,7 @@ void application::show_dialog_hothouse_works(Wt::WText* title)
 
     auto* harvest_date_label = dialog->contents()->addNew<Wt::WLabel>(u8" ");
     auto* harvest_date_edit = dialog->contents()->addNew<Wt::WDateEdit>();
-    harvest_date_edit->setDate(works->harvest_work);
+    harvest_date_edit->setDate(works.harvest);
     if (user_role_ == models::user_account::role::admin)
     {
         harvest_date_edit->setSelectable(true);
@@ -509,15 +688,10 @@ void application::show_dialog_hothouse_works(Wt::WText* title)
 
     dialog->contents()->addNew<Wt::WBreak>();
 
-    std::set<Wt::WDate> dates;
     auto* label_calendar_fertilizer = dialog->contents()->addNew<Wt::WLabel>(u8"");
     auto* calendar_fertilizer = dialog->contents()->addNew<Wt::WCalendar>();
     calendar_fertilizer->setSelectionMode(Wt::SelectionMode::Extended);
-    for (const auto& pdate : works->fertilizer_works)
-    {
-        dates.insert(pdate->date);
-    }
-    calendar_fertilizer->select(dates);
+    calendar_fertilizer->select(works.fertilizer_dates);
 
     if (user_role_ == models::user_account::role::admin)
     {
@@ -530,15 +704,10 @@ void application::show_dialog_hothouse_works(Wt::WText* title)
 
     dialog->contents()->addNew<Wt::WBreak>();
 
-    dates.clear();
     auto* label_calendar_watering = dialog->contents()->addNew<Wt::WLabel>(u8"");
     auto* calendar_watering = dialog->contents()->addNew<Wt::WCalendar>();
     calendar_watering->setSelectionMode(Wt::SelectionMode::Extended);
-    for (const auto& pdate : works->watering_works)
-    {
-        dates.insert(pdate->date);
-    }
-    calendar_watering->select(dates);
+    calendar_watering->select(works.watering_dates);
 
     if (user_role_ == models::user_account::role::admin)
     {
@@ -554,6 +723,7 @@ void application::show_dialog_hothouse_works(Wt::WText* title)
     if (user_role_ == models::user_account::role::admin)
     {
         Wt::WPushButton* ok = dialog->footer()->addNew<Wt::WPushButton>(u8"");
+        ok->setObjectName(object_name::works_save);
         ok->setDefault(true);
         ok->addStyleClass("btn-success");
         ok->clicked().connect(
@@ -568,16 +738,16 @@ void application::show_dialog_hothouse_works(Wt::WText* title)
     quit->clicked().connect(dialog, &Wt::WDialog::reject);
 
     dialog->finished().connect(
-        [this, dialog, title, sowing_date_edit, harvest_date_edit, calendar_fertilizer, calendar_watering]
+        [this, dialog, hothouse_id, sowing_date_edit, harvest_date_edit, calendar_fertilizer, calendar_watering]
     {
         if (dialog->result() == Wt::DialogCode::Accepted)
         {
-            handle_change_hothouse_works(
-                title->text().toUTF8(),
-                sowing_date_edit->date(),
-                harvest_date_edit->date(),
-                calendar_fertilizer->selection(),
-                calendar_watering->selection());
+            models::season_dates works;
+            works.sowing = sowing_date_edit->date();
+            works.harvest = harvest_date_edit->date();
+            works.fertilizer_dates = calendar_fertilizer->selection();
+            works.watering_dates = calendar_watering->selection();
+            handle_change_hothouse_works(hothouse_id, works);
         }
         root()->removeChild(dialog);
     });
@@ -585,106 +755,28 @@ void application::show_dialog_hothouse_works(Wt::WText* title)
     dialog->show();
 }
 
-void application::handle_change_hothouse_works(
-    const std::string& title,
-    const Wt::WDate& sowing_date,
-    const Wt::WDate& harvest_date,
-    const std::set<Wt::WDate>& fertilizer_dates,
-    const std::set<Wt::WDate>& watering_dates)
-{
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::ptr<models::hothouse> hothouse =
-        db_session_.find<models::hothouse>().where("title = ?").bind(title).limit(1);
-    Wt::Dbo::ptr<models::works> works = hothouse->works.lock();
-    assert(works);
-
-    if (sowing_date != works->sowing_work)
-    {
-        works.modify()->sowing_work = sowing_date;
-    }
-
-    if (harvest_date != works->harvest_work)
-    {
-        works.modify()->harvest_work = harvest_date;
-    }
-
-    works.modify()->fertilizer_works.clear();
-    for (const Wt::WDate& date : fertilizer_dates)
-    {
-        works.modify()->fertilizer_works.insert(db_session_.addNew<models::fertilizer_works>(date));
-    }
-
-    works.modify()->watering_works.clear();
-    for (const Wt::WDate& date : watering_dates)
-    {
-        works.modify()->watering_works.insert(db_session_.addNew<models::watering_works>(date));
-    }
-}
-
-void application::handle_delete_hothouse(const Wt::WTableRow* row, const Wt::WString& hothouse_title)
+void application::handle_change_hothouse_works(long long hothouse_id, const models::season_dates& works)
 {
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::ptr<models::hothouse> hothouse =
-        db_session_.find<models::hothouse>().where("title = ?").bind(hothouse_title).limit(1);
-    hothouse.remove();
-    row->table()->removeRow(row->rowNum());
-    update_crops_table();
+    const metrics::handler_scope scope("handle_change_hothouse_works");
+    check_outcome(repository_.change_hothouse_works(hothouse_id, works), {});
 }
 
-void application::add_crop_row(Wt::WTable& table, int index, const agromaster::models::crop& crop)
+void application::handle_delete_hothouse(long long hothouse_id)
 {
-    constexpr char style_class[] = "text-center";
-    auto crop_title = table.elementAt(index, 0)->addNew<Wt::WText>(crop.title);
-    table.elementAt(index, 0)->setStyleClass(style_class);
-    table.elementAt(index, 1)->addNew<Wt::WText>(std::to_string(crop.hothouses.size()));
-    table.elementAt(index, 1)->setStyleClass(style_class);
-    table.elementAt(index, 2)->addNew<Wt::WText>(
-        std::to_string(std::accumulate(crop.hothouses.begin(), crop.hothouses.end(), 0.0,
-            [](double value, const Wt::Dbo::ptr<agromaster::models::hothouse>& h)
-    {
-        return value + h->yields;
-    })));
-    table.elementAt(index, 2)->setStyleClass(style_class);
-    table.elementAt(index, 3)->addNew<Wt::WText>(
-        std::to_string(std::accumulate(crop.hothouses.begin(), crop.hothouses.end(), 0.0,
-            [](double value, const Wt::Dbo::ptr<agromaster::models::hothouse>& h)
-    {
-        return value + h->spent_fertilizers;
-    })));
-    table.elementAt(index, 3)->setStyleClass(style_class);
-    table.elementAt(index, 4)->addNew<Wt::WPushButton>(u8"")->
-        clicked().connect(
-            [this, crop_title]()
-    {
-        show_dialog_crop_schedules(crop_title);
-    });
-    table.elementAt(index, 4)->setStyleClass(style_class);
-    if (user_role_ == agromaster::models::user_account::role::admin)
+    const metrics::handler_scope scope("handle_delete_hothouse");
+    change_set changes;
+    if (check_outcome(repository_.delete_hothouse(hothouse_id, changes), {}))
     {
-        table.elementAt(index, 5)->addNew<Wt::WPushButton>(u8"")->
-            clicked().connect(
-                [this, crop_title]()
-        {
-            show_dialog_change_crop(crop_title);
-        });
-        table.elementAt(index, 5)->setStyleClass(style_class);
-        table.elementAt(index, 6)->addNew<Wt::WPushButton>(u8"")->
-            clicked().connect(
-                [this, row = table.rowAt(index), crop_title]()
-        {
-            handle_delete_crop(row, crop_title->text());
-        });
-        table.elementAt(index, 6)->setStyleClass(style_class);
+        publish_changes(changes);
     }
 }
 
 void application::set_crops_table()
 {
+    const metrics::handler_scope scope("set_crops_table");
+    catalog_cache::crops_type crops = repository_.crops();
     crops_ = main_stack_->addNew<Wt::WContainerWidget>();
 
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::collection<Wt::Dbo::ptr<models::crop>> crops = db_session_.find<models::crop>();
-
     if (user_role_ == models::user_account::role::admin)
     {
         auto add_new_crop_button = crops_->addNew<Wt::WPushButton>(u8"");
@@ -692,39 +784,70 @@ void application::set_crops_table()
         add_new_crop_button->clicked().connect(this, &application::show_dialog_add_crop);
     }
 
-    auto crops_table = crops_->addNew<Wt::WTable>();
-    crops_table->addStyleClass("table table-striped");
-    crops_table->setWidth("100%");
-    int i = 0;
-
-    crops_table->setHeaderCount(1);
-    crops_table->elementAt(i, 0)->addNew<Wt::WText>(u8"");
-    crops_table->elementAt(i, 1)->addNew<Wt::WText>(u8" ");
-    crops_table->elementAt(i, 2)->addNew<Wt::WText>(u8", ");
-    crops_table->elementAt(i, 3)->addNew<Wt::WText>(u8" , ");
-    crops_table->elementAt(i, 4)->addNew<Wt::WText>("");
-    if (user_role_ == agromaster::models::user_account::role::admin)
-    {
-        crops_table->elementAt(i, 5)->addNew<Wt::WText>("");
-        crops_table->elementAt(i, 6)->addNew<Wt::WText>("");
+    auto export_link = crops_->addNew<Wt::WAnchor>(
+        Wt::WLink(std::make_shared<export_resource>(connection_pool_, export_resource::table::crops)),
+        u8"  CSV");
+    export_link->setStyleClass("btn btn-outline-success m-3");
+
+    crops_model_ = std::make_shared<crops_model>(crops, user_role_ == models::user_account::role::admin);
+
+    auto crops_table = crops_->addNew<Wt::WTableView>();
+    crops_table->setObjectName(object_name::crops_table);
+    crops_table->setModel(crops_model_);
+    crops_table->setAlternatingRowColors(true);
+    crops_table->setSelectionMode(Wt::SelectionMode::None);
+    crops_table->setSortingEnabled(false);
+    crops_table->setHeaderHeight(40);
+    crops_table->setRowHeight(40);
+    crops_table->setHeight(600);
+    for (int column = 0; column < crops_model_->columnCount(); ++column)
+    {
+        crops_table->setColumnWidth(column, column < crops_model::schedules_column ? 220 : 110);
     }
-    ++i;
 
-    for (const Wt::Dbo::ptr<models::crop> crop : crops)
+    // Clicks resolve to the id drawn in the cell, not to whatever row now sits under it.
+    auto actions = std::make_shared<record_action_delegate>(
+        [this](int column, long long crop_id) { handle_crop_action(column, crop_id); });
+    for (int column = crops_model::schedules_column; column < crops_model_->columnCount(); ++column)
     {
-        add_crop_row(*crops_table, i, *crop);
-        ++i;
+        crops_table->setItemDelegateForColumn(column, actions);
     }
 }
 
-void application::update_crops_table()
+void application::handle_crop_action(int column, long long crop_id)
 {
-    main_stack_->removeWidget(crops_);
-    set_crops_table();
+    switch (column)
+    {
+    case crops_model::schedules_column:
+        show_dialog_crop_schedules(crop_id);
+        break;
+    case crops_model::change_column:
+        show_dialog_change_crop(crop_id);
+        break;
+    case crops_model::delete_column:
+    {
+        const catalog_cache::crops_type crops = repository_.crops();
+        const auto crop = std::find_if(crops->begin(), crops->end(),
+            [crop_id](const models::crop_summary& candidate) { return candidate.id == crop_id; });
+        if (crop == crops->end())
+        {
+            check_outcome(catalog_repository::outcome::not_found, {});
+            return;
+        }
+
+        confirm_delete(
+            Wt::WString(u8"  {1}?").arg(Wt::WString::fromUTF8(crop->title)),
+            [this, crop_id] { handle_delete_crop(crop_id); });
+        break;
+    }
+    default:
+        break;
+    }
 }
 
 void application::show_dialog_add_crop()
 {
+    const metrics::handler_scope scope("show_dialog_add_crop");
     auto dialog = root()->addNew<Wt::WDialog>(u8"  ");
 
     Wt::WLabel* label = dialog->contents()->addNew<Wt::WLabel>(u8"");
@@ -779,42 +902,17 @@ void application::show_dialog_add_crop()
 
 void application::handle_add_crop(const std::string& title)
 {
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::ptr<models::crop> existing_crop =
-        db_session_.find<models::crop>().where("title = ?").bind(title).limit(1);
-    if (existing_crop)
-    {
-        auto message_box =
-            root()->addChild(std::make_unique<Wt::WMessageBox>(
-                u8"",
-                u8"<p>     !</p>",
-                Wt::Icon::Critical,
-                Wt::StandardButton::Ok));
-
-        message_box->setModal(true);
-        message_box->buttonClicked().connect([this ,message_box] { root()->removeChild(message_box); });
-        message_box->show();
-    }
-    else
+    const metrics::handler_scope scope("handle_add_crop");
+    change_set changes;
+    if (check_outcome(repository_.add_crop(title, changes), u8"<p>     !</p>"))
     {
-        auto new_crop = db_session_.addNew<models::crop>();
-        new_crop.modify()->title = title;
-        new_crop.modify()->schedules = db_session_.addNew<models::schedules>();
-        try
-        {
-            constexpr int table_index = 1;
-            Wt::WTable& crops_table(dynamic_cast<Wt::WTable&>(*crops_->widget(table_index)));
-            add_crop_row(crops_table, crops_table.rowCount(), *new_crop);
-        }
-        catch (const std::bad_cast& error)
-        {
-            log("error") << error.what();
-        }
+        publish_changes(changes);
     }
 }
 
-void application::show_dialog_change_crop(Wt::WText* title)
+void application::show_dialog_change_crop(long long crop_id)
 {
+    const metrics::handler_scope scope("show_dialog_change_crop");
     auto dialog = root()->addNew<Wt::WDialog>(u8" ");
 
     auto* label = dialog->contents()->addNew<Wt::WLabel>(u8" ");
@@ -855,16 +953,11 @@ void application::show_dialog_change_crop(Wt::WText* title)
     cancel->clicked().connect(dialog, &Wt::WDialog::reject);
 
     dialog->finished().connect(
-        [this, dialog, edit, title]
+        [this, dialog, edit, crop_id]
     {
         if (dialog->result() == Wt::DialogCode::Accepted)
         {
-            Wt::Dbo::Transaction transaction(db_session_);
-            Wt::Dbo::ptr<models::crop> crop =
-                db_session_.find<models::crop>().where("title = ?").bind(title->text()).limit(1);
-            crop.modify()->title = edit->text().toUTF8();
-            title->setText(edit->text());
-            update_hothouses_table();
+            handle_change_crop(crop_id, edit->text().toUTF8());
         }
         root()->removeChild(dialog);
     });
@@ -872,14 +965,26 @@ void application::show_dialog_change_crop(Wt::WText* title)
     dialog->show();
 }
 
-void application::show_dialog_crop_schedules(Wt::WText* title)
+void application::handle_change_crop(long long crop_id, const std::string& new_title)
 {
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::ptr<models::crop> crop =
-        db_session_.find<models::crop>().where("title = ?").bind(title->text()).limit(1);
+    const metrics::handler_scope scope("handle_change_crop");
+    change_set changes;
+    if (check_outcome(repository_.rename_crop(crop_id, new_title, changes),
+        u8"<p>     !</p>"))
+    {
+        publish_changes(changes);
+    }
+}
 
-    Wt::Dbo::ptr<models::schedules> schedules = crop->schedules.lock();
-    assert(schedules);
+void application::show_dialog_crop_schedules(long long crop_id)
+{
+    const metrics::handler_scope scope("show_dialog_crop_schedules");
+    models::season_dates schedules;
+    if (!repository_.crop_schedules(crop_id, schedules))
+    {
+        check_outcome(catalog_repository::outcome::not_found, {});
+        return;
+    }
 
     auto dialog = root()->addNew<Wt::WDialog>(u8"");
     dialog->setScrollVisibilityEnabled(true);
@@ -887,7 +992,7 @@ void application::show_dialog_crop_schedules(Wt::WText* title)
 
     auto* sowing_date_label = dialog->contents()->addNew<Wt::WLabel>(u8" ");
     auto* sowing_date_edit = dialog->contents()->addNew<Wt::WDateEdit>();
-    sowing_date_edit->setDate(schedules->sowing_schedule);
+    sowing_date_edit->setDate(schedules.sowing);
     if (user_role_ == models::user_account::role::admin)
     {
         sowing_date_edit->setSelectable(true);
@@ -902,7 +1007,7 @@ void application::show_dialog_crop_schedules(Wt::WText* title)
 
     auto* harvest_date_label = dialog->contents()->addNew<Wt::WLabel>(u8"  ");
     auto* harvest_date_edit = dialog->contents()->addNew<Wt::WDateEdit>();
-    harvest_date_edit->setDate(schedules->harvest_schedule);
+    harvest_date_edit->setDate(schedules.harvest);
     if (user_role_ == models::user_account::role::admin)
     {
         harvest_date_edit->setSelectable(true);
@@ -915,15 +1020,10 @@ void application::show_dialog_crop_schedules(Wt::WText* title)
 
     dialog->contents()->addNew<Wt::WBreak>();
 
-    std::set<Wt::WDate> dates;
     auto* label_calendar_fertilizer = dialog->contents()->addNew<Wt::WLabel>(u8" ");
     auto* calendar_fertilizer = dialog->contents()->addNew<Wt::WCalendar>();
     calendar_fertilizer->setSelectionMode(Wt::SelectionMode::Extended);
-    for (const auto& pdate : schedules->fertilizer_schedules)
-    {
-        dates.insert(pdate->date);
-    }
-    calendar_fertilizer->select(dates);
+    calendar_fertilizer->select(schedules.fertilizer_dates);
 
     if (user_role_ == models::user_account::role::admin)
     {
@@ -936,15 +1036,10 @@ void application::show_dialog_crop_schedules(Wt::WText* title)
 
     dialog->contents()->addNew<Wt::WBreak>();
     
-    dates.clear();
     auto* label_calendar_watering = dialog->contents()->addNew<Wt::WLabel>(u8" ");
     auto* calendar_watering = dialog->contents()->addNew<Wt::WCalendar>();
     calendar_watering->setSelectionMode(Wt::SelectionMode::Extended);
-    for (const auto& pdate : schedules->watering_schedules)
-    {
-        dates.insert(pdate->date);
-    }
-    calendar_watering->select(dates);
+    calendar_watering->select(schedules.watering_dates);
 
     if (user_role_ == models::user_account::role::admin)
     {
@@ -974,16 +1069,16 @@ void application::show_dialog_crop_schedules(Wt::WText* title)
     quit->clicked().connect(dialog, &Wt::WDialog::reject);
 
     dialog->finished().connect(
-        [this, dialog, title, sowing_date_edit, harvest_date_edit, calendar_fertilizer, calendar_watering]
+        [this, dialog, crop_id, sowing_date_edit, harvest_date_edit, calendar_fertilizer, calendar_watering]
     {
         if (dialog->result() == Wt::DialogCode::Accepted)
         {
-            handle_change_crop_schedules(
-                title->text().toUTF8(),
-                sowing_date_edit->date(),
-                harvest_date_edit->date(),
-                calendar_fertilizer->selection(),
-                calendar_watering->selection());
+            models::season_dates schedules;
+            schedules.sowing = sowing_date_edit->date();
+            schedules.harvest = harvest_date_edit->date();
+            schedules.fertilizer_dates = calendar_fertilizer->selection();
+            schedules.watering_dates = calendar_watering->selection();
+            handle_change_crop_schedules(crop_id, schedules);
         }
         root()->removeChild(dialog);
     });
@@ -991,56 +1086,148 @@ void application::show_dialog_crop_schedules(Wt::WText* title)
     dialog->show();
 }
 
-void application::handle_change_crop_schedules(
-    const std::string& title,
-    const Wt::WDate& sowing_date,
-    const Wt::WDate& harvest_date,
-    const std::set<Wt::WDate>& fertilizer_dates,
-    const std::set<Wt::WDate>& watering_dates)
+void application::handle_change_crop_schedules(long long crop_id, const models::season_dates& schedules)
 {
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::ptr<models::crop> crop =
-        db_session_.find<models::crop>().where("title = ?").bind(title).limit(1);
-    Wt::Dbo::ptr<models::schedules> schedules = crop->schedules.lock();
-    assert(schedules);
+    const metrics::handler_scope scope("handle_change_crop_schedules");
+    check_outcome(repository_.change_crop_schedules(crop_id, schedules), {});
+}
 
-    if (sowing_date != schedules->sowing_schedule)
+void application::handle_delete_crop(long long crop_id)
+{
+    const metrics::handler_scope scope("handle_delete_crop");
+    change_set changes;
+    if (check_outcome(repository_.delete_crop(crop_id, changes), {}))
     {
-        schedules.modify()->sowing_schedule = sowing_date;
+        publish_changes(changes);
     }
+}
 
-    if (harvest_date != schedules->harvest_schedule)
+void application::confirm_delete(const Wt::WString& question, std::function<void()> remove)
+{
+    auto message_box =
+        root()->addChild(std::make_unique<Wt::WMessageBox>(
+            u8"",
+            question,
+            Wt::Icon::Warning,
+            Wt::StandardButton::Yes | Wt::StandardButton::No));
+
+    message_box->setModal(true);
+    message_box->buttonClicked().connect(
+        [this, message_box, remove](Wt::StandardButton button)
+    {
+        root()->removeChild(message_box);
+        if (button == Wt::StandardButton::Yes)
+        {
+            remove();
+        }
+    });
+    message_box->show();
+}
+
+void application::show_error(const Wt::WString& message)
+{
+    auto message_box =
+        root()->addChild(std::make_unique<Wt::WMessageBox>(
+            u8"",
+            message,
+            Wt::Icon::Critical,
+            Wt::StandardButton::Ok));
+
+    message_box->setModal(true);
+    message_box->buttonClicked().connect([this, message_box] { root()->removeChild(message_box); });
+    message_box->show();
+}
+
+bool application::check_outcome(catalog_repository::outcome outcome, const Wt::WString& title_taken)
+{
+    switch (outcome)
+    {
+    case catalog_repository::outcome::done:
+        return true;
+    case catalog_repository::outcome::title_taken:
+        show_error(title_taken);
+        return false;
+    case catalog_repository::outcome::not_found:
+        show_error(u8"<p>    .</p>");
+        return false;
+    }
+    return false;
+}
+
+void application::apply_changes(const change_set& changes)
+{
+    const metrics::handler_scope scope("apply_changes");
+    if (changes.empty())
+    {
+        return;
+    }
+
+    std::set<long long> crop_ids = changes.added_crops;
+    crop_ids.insert(changes.changed_crops.begin(), changes.changed_crops.end());
+    for (long long id : changes.removed_crops)
+    {
+        crop_ids.erase(id);
+    }
+
+    catalog_cache::crops_type crops = repository_.crops();
+
+    // Pages not built yet load fresh rows when they are.
+    if (crops_model_)
     {
-        schedules.modify()->harvest_schedule = harvest_date;
+        crops_model_->set_crops(crops);
     }
 
-    schedules.modify()->fertilizer_schedules.clear();
-    for (const Wt::WDate& date : fertilizer_dates)
+    if (hothouses_model_)
     {
-        schedules.modify()->fertilizer_schedules.insert(db_session_.addNew<models::fertilizer_schedules>(date));
+        const std::vector<models::hothouse_summary> hothouses =
+            repository_.hothouses(hothouses_model_->cached(changes.changed_hothouses));
+        for (long long id : changes.removed_crops)
+        {
+            hothouses_model_->remove_crop(id);
+        }
+        for (const models::crop_summary& crop : *crops)
+        {
+            if (crop_ids.count(crop.id))
+            {
+                hothouses_model_->update_crop(crop.id, crop.title);
+            }
+        }
+
+        hothouses_model_->remove_rows(changes.removed_hothouses);
+        hothouses_model_->update_rows(hothouses);
+        hothouses_model_->insert_rows(static_cast<int>(changes.added_hothouses.size()));
     }
+}
 
-    schedules.modify()->watering_schedules.clear();
-    for (const Wt::WDate& date : watering_dates)
+void application::publish_changes(const change_set& changes)
+{
+    if (changes.empty())
     {
-        schedules.modify()->watering_schedules.insert(db_session_.addNew<models::watering_schedules>(date));
+        return;
     }
+
+    catalog_cache::instance().invalidate();
+    apply_changes(changes);
+    change_bus::instance().publish(changes, session_key_);
 }
 
-void application::handle_delete_crop(const Wt::WTableRow* row, const Wt::WString& crop_title)
+void application::handle_published_changes(const change_set& changes)
 {
-    Wt::Dbo::Transaction transaction(db_session_);
-    Wt::Dbo::ptr<models::crop> crop =
-        db_session_.find<models::crop>().where("title = ?").bind(crop_title).limit(1);
-    crop.remove();
-    row->table()->removeRow(row->rowNum());
-    update_hothouses_table();
+    const metrics::handler_scope scope("handle_published_changes");
+    if (!hothouses_model_ && !crops_model_)
+    {
+        return;
+    }
+
+    apply_changes(changes);
+    triggerUpdate();
 }
 
 void application::set_auth_widget()
 {
-    auth_widget_ = root()->addNew<Wt::Auth::AuthWidget>(
-        models::session::auth(), db_session_.users(), db_session_.login());
+    auth_widget_ = root()->addNew<async_auth_widget>(
+        models::session::auth(), db_session_.users(), db_session_.login(), password_workers_);
+    auth_widget_->setObjectName(object_name::auth);
     auth_widget_->model()->addPasswordAuth(&models::session::password_auth());
     auth_widget_->setRegistrationEnabled(true);
     auth_widget_->setWidth("50%");
@@ -1049,26 +1236,20 @@ void application::set_auth_widget()
 
 void application::handle_auth()
 {
+    const metrics::handler_scope scope("handle_auth");
     if (db_session_.login().loggedIn())
     {
-        Wt::Dbo::Transaction transaction(db_session_);
         const Wt::Auth::User& u = db_session_.login().user();
-        Wt::Dbo::ptr<agromaster::models::AuthInfo> auth_info = db_session_.users().find(u);
-        Wt::Dbo::ptr<models::user_account> user_acc = auth_info->user();
-        if (!user_acc) {
-            user_acc = db_session_.add(std::make_unique<models::user_account>(models::user_account::role::visitor));
-            auth_info.modify()->setUser(user_acc);
-        }
-        user_role_ = user_acc->role;
+        user_role_ = repository_.user_role();
 
-        Wt::WString login_name = u.identity(Wt::Auth::Identity::LoginName);
+        const Wt::WString& login_name = db_session_.login_name();
         set_navigation_bar(login_name);
         main_stack_ = root()->addNew<Wt::WStackedWidget>();
         main_stack_->setContentAlignment(Wt::AlignmentFlag::Center);
-        set_hothouses_table();
-        set_crops_table();
         auth_widget_->hide();
+        // Builds the hothouses page only; the crops page waits for its first visit or the prefetch.
         setInternalPath(internal_path::hothouses);
+        handle_path_changes();
         log("notice")
             << "User " << u.id()
             << " (" << login_name << ")"
@@ -1077,8 +1258,14 @@ void application::handle_auth()
     else
     {
         auth_widget_->show();
+        hothouses_model_.reset();
+        crops_model_.reset();
+        hothouses_ = nullptr;
+        crops_ = nullptr;
         root()->removeWidget(navigation_);
         root()->removeWidget(main_stack_);
+        navigation_ = nullptr;
+        main_stack_ = nullptr;
         setInternalPath(internal_path::root);
         log("notice") << "User logged out.";
     }
@@ -2,20 +2,31 @@
 #ifndef AGROMASTER_APPLICATION_HPP_
 #define AGROMASTER_APPLICATION_HPP_
 
+#include <chrono>
+#include <functional>
+#include <string>
+
 #include <Wt/Auth/AuthWidget.h>
 #include <Wt/Dbo/backend/Postgres.h>
 #include <Wt/Dbo/Dbo.h>
 #include <Wt/Dbo/FixedSqlConnectionPool.h>
 #include <Wt/Dbo/SqlConnectionPool.h>
+#include <Wt/Http/Request.h>
 #include <Wt/WApplication.h>
 #include <Wt/WContainerWidget.h>
 #include <Wt/WEnvironment.h>
 #include <Wt/WNavigationBar.h>
 #include <Wt/WServer.h>
 #include <Wt/WStackedWidget.h>
+#include <Wt/WTable.h>
 #include <Wt/WText.h>
 
+#include "catalog_repository.hpp"
+#include "change_set.hpp"
+#include "crops_model.hpp"
+#include "hothouses_model.hpp"
 #include "models.hpp"
+#include "worker_pool.hpp"
 
 namespace agromaster
 { 
@@ -27,67 +38,116 @@ static constexpr char hothouses[] = "/hothouses/";
 static constexpr char crops[] = "/crops/";
 } // internal_path
 
+// Object names of the widgets that headless drivers such as the load test look up.
+namespace object_name
+{
+static constexpr char auth[] = "auth";
+static constexpr char hothouses_table[] = "hothouses-table";
+static constexpr char crops_table[] = "crops-table";
+static constexpr char works_dialog[] = "works-dialog";
+static constexpr char works_save[] = "works-save";
+} // object_name
+
 class application final : public Wt::WApplication
 {
 public:
-    application(const Wt::WEnvironment& env, Wt::Dbo::SqlConnectionPool& connection_pool);
+    struct settings
+    {
+        // Delay after the first page of a session arrives before the other pages are built
+        // in the background; negative disables the prefetch.
+        std::chrono::milliseconds prefetch_delay{ 500 };
+
+        static settings load(const Wt::WServer& server);
+    };
+
+    application(
+        const Wt::WEnvironment& env,
+        Wt::Dbo::SqlConnectionPool& connection_pool,
+        worker_pool& password_workers,
+        const settings& config);
+    ~application() override;
+
+protected:
+    // Times every request of the session for the metrics registry, admits its database
+    // work as reads and shows a notice instead of failing the request when the connection
+    // pool is overloaded.
+    void notify(const Wt::WEvent& event) override;
 
 private:
+    // Sessions report their footprint to the metrics registry at most this often.
+    static constexpr std::chrono::seconds footprint_interval{ 5 };
+
+    // Reports the widgets of the session and the rows its models keep to the metrics registry.
+    void account_memory();
+
+    // Builds a page of main_stack_ on its first visit and keeps it afterwards.
     void handle_path_changes();
+    void schedule_prefetch();
+    void prefetch_pages();
     void set_navigation_bar(const Wt::WString& login_name);
     
-    void add_hothouse_row(Wt::WTable& table, int index, const agromaster::models::hothouse& hothouse);
-    void set_hothouses_table();    
-    void update_hothouses_table();
+    void set_hothouses_table();
+    void handle_hothouse_action(int column, long long hothouse_id);
     void show_dialog_add_hothouse();
-    void handle_add_hothouse(const std::string& title, const std::string& crop_title);
-    void show_dialog_change_hothouse(
-        Wt::WText* current_title,
-        Wt::WText* current_crop_title,
-        Wt::WText* current_yields,
-        Wt::WText* current_spent_fertilizers);
+    void handle_add_hothouse(const std::string& title, long long crop_id);
+    void show_dialog_change_hothouse(const models::hothouse_summary& hothouse);
     void handle_change_hothouse(
+        long long hothouse_id,
         const std::string& new_title,
-        const std::string& new_crop,
-        const std::string& new_yields,
-        const std::string& new_spent_fertilizers,
-        Wt::WText* current_title,
-        Wt::WText* current_crop_title,
-        Wt::WText* current_yields,
-        Wt::WText* current_spent_fertilizers);
-    void show_dialog_hothouse_works(Wt::WText* title);
-    void handle_change_hothouse_works(
-        const std::string& title,
-        const Wt::WDate& sowing_date,
-        const Wt::WDate& harvest_date,
-        const std::set<Wt::WDate>& fertilizer_dates,
-        const std::set<Wt::WDate>& watering_dates);
-    void handle_delete_hothouse(const Wt::WTableRow* row, const Wt::WString& hothouse_title);
-
-    void add_crop_row(Wt::WTable& table, int index, const agromaster::models::crop& crop);
+        long long new_crop_id,
+        double new_yields,
+        double new_spent_fertilizers);
+    void show_dialog_hothouse_works(long long hothouse_id);
+    void handle_change_hothouse_works(long long hothouse_id, const models::season_dates& works);
+    void handle_delete_hothouse(long long hothouse_id);
+    void show_dialog_import();
+    void handle_import(const std::vector<Wt::Http::UploadedFile>& files);
+
     void set_crops_table();
-    void update_crops_table();
+    void handle_crop_action(int column, long long crop_id);
     void show_dialog_add_crop();
     void handle_add_crop(const std::string& title);
-    void show_dialog_change_crop(Wt::WText* title);
-    void show_dialog_crop_schedules(Wt::WText* title);
-    void handle_change_crop_schedules(
-        const std::string& title,
-        const Wt::WDate& sowing_date,
-        const Wt::WDate& harvest_date,
-        const std::set<Wt::WDate>& fertilizer_dates,
-        const std::set<Wt::WDate>& watering_dates);
-    void handle_delete_crop(const Wt::WTableRow* row, const Wt::WString& crop_title);
+    void show_dialog_change_crop(long long crop_id);
+    void handle_change_crop(long long crop_id, const std::string& new_title);
+    void show_dialog_crop_schedules(long long crop_id);
+    void handle_change_crop_schedules(long long crop_id, const models::season_dates& schedules);
+    void handle_delete_crop(long long crop_id);
+
+    void show_error(const Wt::WString& message);
+    // Asks before a delete, naming the record the click resolved to.
+    void confirm_delete(const Wt::WString& question, std::function<void()> remove);
+    // Shows the error of a failed edit; title_taken is the message for a duplicate title.
+    // Returns whether the edit was done.
+    bool check_outcome(catalog_repository::outcome outcome, const Wt::WString& title_taken);
+
+    // Patches the rows listed in changes; costs two queries at most, whatever the table sizes.
+    void apply_changes(const change_set& changes);
+    // Applies changes committed by this session, invalidates the shared catalog_cache and
+    // sends the changes to the other live sessions over the change_bus.
+    void publish_changes(const change_set& changes);
+    void handle_published_changes(const change_set& changes);
 
     void set_auth_widget();
     void handle_auth();
 
+    const settings settings_;
+    // The session id at construction. Wt gives the session a new id at login, so
+    // bookkeeping that has to survive the change is keyed by this one.
+    const std::string session_key_;
+    // The id the change_bus posts to; notify() follows sessionId() with it.
+    std::string bus_session_id_;
+    Wt::Dbo::SqlConnectionPool& connection_pool_;
     models::session db_session_;
+    catalog_repository repository_;
+    worker_pool& password_workers_;
     Wt::Auth::AuthWidget* auth_widget_ = nullptr;
     Wt::WNavigationBar* navigation_ = nullptr;
     Wt::WStackedWidget* main_stack_ = nullptr;
     Wt::WContainerWidget* hothouses_ = nullptr;
+    std::shared_ptr<hothouses_model> hothouses_model_;
     Wt::WContainerWidget* crops_ = nullptr;
+    std::shared_ptr<crops_model> crops_model_;
+    std::chrono::steady_clock::time_point footprint_measured_;
     enum class models::user_account::role user_role_ = models::user_account::role::visitor;
 };
 
@@ -0,0 +1,413 @@
+#include "async_auth_widget.hpp"
+
+#include <functional>
+#include <string>
+#include <utility>
+
+#include <Wt/Auth/AbstractPasswordService.h>
+#include <Wt/Auth/AbstractUserDatabase.h>
+#include <Wt/Auth/AuthModel.h>
+#include <Wt/Auth/Identity.h>
+#include <Wt/Auth/RegistrationModel.h>
+#include <Wt/Auth/RegistrationWidget.h>
+#include <Wt/Auth/UpdatePasswordWidget.h>
+#include <Wt/Auth/User.h>
+#include <Wt/WApplication.h>
+#include <Wt/WEvent.h>
+#include <Wt/WLineEdit.h>
+#include <Wt/WPushButton.h>
+#include <Wt/WServer.h>
+
+#include "models/primed_verifier.hpp"
+
+namespace
+{
+
+using transaction_ptr = std::unique_ptr<Wt::Auth::AbstractUserDatabase::Transaction>;
+using primed_results = agromaster::models::primed_verifier::results;
+
+const char* const workers_busy = u8" ,     ";
+
+// Fills results on the password workers and hands them to finish back in the session.
+// Returns false when the workers are saturated.
+bool prime_on_workers(
+    agromaster::worker_pool& password_workers,
+    std::function<void(primed_results&)> compute,
+    std::function<void(const primed_results&)> finish)
+{
+    const std::string session_id = Wt::WApplication::instance()->sessionId();
+    return password_workers.submit(
+        [compute, finish, session_id]
+    {
+        primed_results primed;
+        compute(primed);
+        Wt::WServer::instance()->post(session_id,
+            [finish, primed]
+        {
+            finish(primed);
+            Wt::WApplication::instance()->triggerUpdate();
+        });
+    });
+}
+
+// Hashes the chosen password on the workers before RegistrationWidget::doRegister runs.
+class async_registration_widget final : public Wt::Auth::RegistrationWidget
+{
+public:
+    async_registration_widget(Wt::Auth::AuthWidget* auth_widget, agromaster::worker_pool& password_workers)
+        : Wt::Auth::RegistrationWidget(auth_widget)
+        , password_workers_(password_workers)
+    {
+    }
+
+protected:
+    void doRegister() override
+    {
+        if (hashing_)
+        {
+            return;
+        }
+
+        updateModel(model());
+        const Wt::WString password = model()->valueText(Wt::Auth::RegistrationModel::ChoosePasswordField);
+        bool valid = false;
+        {
+            transaction_ptr transaction(model()->users().startTransaction());
+            valid = model()->validate();
+            if (transaction)
+            {
+                transaction->commit();
+            }
+        }
+
+        // Invalid forms and identified registrations without a password need no hashing.
+        if (!valid || password.empty() || !model()->passwordAuth())
+        {
+            Wt::Auth::RegistrationWidget::doRegister();
+            return;
+        }
+
+        hashing_ = true;
+        const Wt::Auth::AbstractPasswordService::AbstractVerifier* verifier = model()->passwordAuth()->verifier();
+        const bool queued = prime_on_workers(password_workers_,
+            [verifier, password](primed_results& primed)
+        {
+            primed.hashes.emplace(password.toUTF8(), verifier->hashPassword(password));
+        },
+            bindSafe(&async_registration_widget::finish_register));
+
+        if (!queued)
+        {
+            hashing_ = false;
+            model()->setValidation(Wt::Auth::RegistrationModel::ChoosePasswordField,
+                Wt::WValidator::Result(Wt::ValidationState::Invalid, workers_busy));
+            updateView(model());
+        }
+    }
+
+private:
+    void finish_register(const primed_results& primed)
+    {
+        hashing_ = false;
+        const agromaster::models::primed_verifier::scope scope(primed);
+        Wt::Auth::RegistrationWidget::doRegister();
+    }
+
+    agromaster::worker_pool& password_workers_;
+    bool hashing_ = false;
+};
+
+// Checks the current password and hashes the new one on the workers before the update
+// runs. UpdatePasswordWidget::doUpdate is private, so the OK button it binds is kept
+// unbound and clicked once the results are in.
+class async_update_password_widget final : public Wt::Auth::UpdatePasswordWidget
+{
+public:
+    async_update_password_widget(
+        const Wt::Auth::User& user,
+        std::unique_ptr<Wt::Auth::RegistrationModel> registration,
+        Wt::Auth::RegistrationModel* registration_model,
+        const std::shared_ptr<Wt::Auth::AuthModel>& authentication,
+        agromaster::worker_pool& password_workers)
+        : Wt::Auth::UpdatePasswordWidget(user, std::move(registration), authentication)
+        , user_(user)
+        , registration_(registration_model)
+        , authentication_(authentication)
+        , password_workers_(password_workers)
+        , update_button_(removeWidget("ok-button"))
+    {
+        auto ok_button = bindWidget("ok-button", std::make_unique<Wt::WPushButton>(tr("Wt.WMessageBox.Ok")));
+        ok_button->clicked().connect(this, &async_update_password_widget::start_update);
+        if (authentication_)
+        {
+            authentication_->configureThrottling(ok_button);
+        }
+    }
+
+private:
+    void start_update()
+    {
+        if (hashing_)
+        {
+            return;
+        }
+
+        updateModel(registration_);
+        if (authentication_)
+        {
+            updateModel(authentication_.get());
+        }
+        const Wt::WString password = registration_->valueText(Wt::Auth::RegistrationModel::ChoosePasswordField);
+        const Wt::WString current = authentication_
+            ? authentication_->valueText(Wt::Auth::AuthModel::PasswordField)
+            : Wt::WString();
+        Wt::Auth::PasswordHash current_hash;
+        if (!current.empty())
+        {
+            transaction_ptr transaction(user_.database()->startTransaction());
+            current_hash = user_.password();
+            if (transaction)
+            {
+                transaction->commit();
+            }
+        }
+
+        if (password.empty())
+        {
+            finish_update(primed_results());
+            return;
+        }
+
+        hashing_ = true;
+        const Wt::Auth::AbstractPasswordService::AbstractVerifier* verifier = registration_->passwordAuth()->verifier();
+        const bool queued = prime_on_workers(password_workers_,
+            [verifier, password, current, current_hash](primed_results& primed)
+        {
+            primed.hashes.emplace(password.toUTF8(), verifier->hashPassword(password));
+            if (!current.empty() && !current_hash.value().empty())
+            {
+                primed.verifications.emplace(
+                    std::make_pair(current.toUTF8(), current_hash.value()), verifier->verify(current, current_hash));
+            }
+        },
+            bindSafe(&async_update_password_widget::finish_update));
+
+        if (!queued)
+        {
+            hashing_ = false;
+            registration_->setValidation(Wt::Auth::RegistrationModel::ChoosePasswordField,
+                Wt::WValidator::Result(Wt::ValidationState::Invalid, workers_busy));
+            updateView(registration_);
+        }
+    }
+
+    void finish_update(const primed_results& primed)
+    {
+        hashing_ = false;
+        const agromaster::models::primed_verifier::scope scope(primed);
+        static_cast<Wt::WPushButton*>(update_button_.get())->clicked().emit(Wt::WMouseEvent());
+    }
+
+    const Wt::Auth::User user_;
+    Wt::Auth::RegistrationModel* const registration_;
+    const std::shared_ptr<Wt::Auth::AuthModel> authentication_;
+    agromaster::worker_pool& password_workers_;
+    // The button bound by UpdatePasswordWidget, still connected to its doUpdate.
+    const std::unique_ptr<Wt::WWidget> update_button_;
+    bool hashing_ = false;
+};
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+async_auth_widget::async_auth_widget(
+    const Wt::Auth::AuthService& auth_service,
+    Wt::Auth::AbstractUserDatabase& users,
+    Wt::Auth::Login& login,
+    worker_pool& password_workers)
+    : Wt::Auth::AuthWidget(auth_service, users, login)
+    , password_workers_(password_workers)
+{
+}
+
+void async_auth_widget::createPasswordLoginView()
+{
+    Wt::Auth::AuthWidget::createPasswordLoginView();
+    if (!model()->passwordAuth())
+    {
+        return;
+    }
+
+    // Replaces the button bound by AuthWidget together with its synchronous handler.
+    login_button_ = bindWidget("login", std::make_unique<Wt::WPushButton>(tr("Wt.Auth.login")));
+    login_button_->clicked().connect(this, &async_auth_widget::attempt_password_login);
+    model()->configureThrottling(login_button_);
+}
+
+std::unique_ptr<Wt::WWidget> async_auth_widget::createFormWidget(Wt::WFormModel::Field field)
+{
+    if (field != Wt::Auth::AuthModel::PasswordField)
+    {
+        return Wt::Auth::AuthWidget::createFormWidget(field);
+    }
+
+    auto password = std::make_unique<Wt::WLineEdit>();
+    password->setEchoMode(Wt::EchoMode::Password);
+    password->enterPressed().connect(this, &async_auth_widget::attempt_password_login);
+    return std::move(password);
+}
+
+std::unique_ptr<Wt::WWidget> async_auth_widget::createRegistrationView(const Wt::Auth::Identity& id)
+{
+    auto registration = createRegistrationModel();
+    if (id.isValid())
+    {
+        registration->registerIdentified(id);
+    }
+
+    auto view = std::make_unique<async_registration_widget>(this, password_workers_);
+    view->setModel(std::move(registration));
+    return std::move(view);
+}
+
+std::unique_ptr<Wt::WWidget> async_auth_widget::createUpdatePasswordView(const Wt::Auth::User& user, bool promptPassword)
+{
+    // UpdatePasswordWidget drops the prompt itself for users without a password.
+    std::shared_ptr<Wt::Auth::AuthModel> authentication;
+    if (promptPassword)
+    {
+        transaction_ptr transaction(model()->users().startTransaction());
+        if (!user.password().empty())
+        {
+            authentication = std::make_shared<Wt::Auth::AuthModel>(*model()->baseAuth(), model()->users());
+            authentication->addPasswordAuth(model()->passwordAuth());
+        }
+        if (transaction)
+        {
+            transaction->commit();
+        }
+    }
+
+    auto registration = createRegistrationModel();
+    Wt::Auth::RegistrationModel* registration_model = registration.get();
+    return std::make_unique<async_update_password_widget>(
+        user, std::move(registration), registration_model, authentication, password_workers_);
+}
+
+void async_auth_widget::attempt_password_login()
+{
+    if (verifying_)
+    {
+        return;
+    }
+
+    updateModel(model());
+    const Wt::Auth::AbstractPasswordService* password_service = model()->passwordAuth();
+    const Wt::WString password = model()->valueText(Wt::Auth::AuthModel::PasswordField);
+
+    Wt::Auth::User user;
+    Wt::Auth::PasswordHash hash;
+    {
+        transaction_ptr transaction(model()->users().startTransaction());
+        user = model()->users().findWithIdentity(
+            Wt::Auth::Identity::LoginName,
+            model()->valueText(Wt::Auth::AuthModel::LoginNameField));
+        if (user.isValid() && password_service->delayForNextAttempt(user) == 0)
+        {
+            hash = user.password();
+        }
+        if (transaction)
+        {
+            transaction->commit();
+        }
+    }
+
+    if (hash.value().empty() || password.empty())
+    {
+        attemptPasswordLogin();
+        return;
+    }
+
+    verifying_ = true;
+    verifying_user_id_ = user.id();
+    const Wt::Auth::AbstractPasswordService::AbstractVerifier* verifier = password_service->verifier();
+    const std::string session_id = Wt::WApplication::instance()->sessionId();
+    auto finish = bindSafe(&async_auth_widget::finish_password_login);
+    const bool queued = password_workers_.submit(
+        [verifier, password, hash, session_id, finish]
+    {
+        const bool verified = verifier->verify(password, hash);
+        Wt::WServer::instance()->post(session_id,
+            [finish, verified]
+        {
+            finish(verified);
+            Wt::WApplication::instance()->triggerUpdate();
+        });
+    });
+
+    if (!queued)
+    {
+        verifying_ = false;
+        model()->setValidation(Wt::Auth::AuthModel::PasswordField,
+            Wt::WValidator::Result(Wt::ValidationState::Invalid, u8" ,     "));
+        updateView(model());
+    }
+}
+
+void async_auth_widget::finish_password_login(bool verified)
+{
+    verifying_ = false;
+
+    Wt::Auth::User user;
+    int delay = 0;
+    {
+        transaction_ptr transaction(model()->users().startTransaction());
+        user = model()->users().findWithId(verifying_user_id_);
+        if (user.isValid())
+        {
+            // Same bookkeeping as PasswordService::verifyPassword: failed attempt count and time.
+            user.setAuthenticated(verified);
+            if (!verified)
+            {
+                delay = model()->passwordAuth()->delayForNextAttempt(user);
+            }
+        }
+        if (transaction)
+        {
+            transaction->commit();
+        }
+    }
+
+    if (verified && user.isValid())
+    {
+        model()->validateField(Wt::Auth::AuthModel::LoginNameField);
+        model()->validateField(Wt::Auth::AuthModel::RememberMeField);
+        model()->setValid(Wt::Auth::AuthModel::PasswordField);
+        if (model()->login(login()))
+        {
+            return;
+        }
+    }
+    else
+    {
+        model()->setValidation(Wt::Auth::AuthModel::PasswordField,
+            Wt::WValidator::Result(Wt::ValidationState::Invalid, tr("Wt.Auth.password-invalid")));
+        update_throttling(delay);
+    }
+    updateView(model());
+}
+
+void async_auth_widget::update_throttling(int delay)
+{
+    if (!login_button_ || !model()->passwordAuth()->attemptThrottlingEnabled())
+    {
+        return;
+    }
+
+    login_button_->doJavaScript(
+        "jQuery.data(" + login_button_->jsRef() + ", 'throttle').reset(" + std::to_string(delay) + ");");
+}
+
+} // agromaster
\ No newline at end of file
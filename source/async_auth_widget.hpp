@@ -0,0 +1,56 @@
+#pragma once
+#ifndef AGROMASTER_ASYNC_AUTH_WIDGET_HPP_
+#define AGROMASTER_ASYNC_AUTH_WIDGET_HPP_
+
+#include <memory>
+#include <string>
+
+#include <Wt/Auth/AuthWidget.h>
+#include <Wt/Core/observing_ptr.hpp>
+#include <Wt/WPushButton.h>
+
+#include "worker_pool.hpp"
+
+namespace agromaster
+{
+
+// Auth widget that checks passwords on a worker_pool instead of the request thread.
+//
+// The login button and the password field's enter key start the check; the stored hash
+// is read on the request thread, bcrypt runs on the pool and the result is applied back
+// in the session through Wt::WServer::post. Unknown login names and throttled attempts
+// need no hashing and take the synchronous AuthWidget path. Registration and password
+// updates hash on the same pool and then replay Wt's own code with the results primed in
+// models::primed_verifier, so that code does not run bcrypt again.
+class async_auth_widget final : public Wt::Auth::AuthWidget
+{
+public:
+    async_auth_widget(
+        const Wt::Auth::AuthService& auth_service,
+        Wt::Auth::AbstractUserDatabase& users,
+        Wt::Auth::Login& login,
+        worker_pool& password_workers);
+
+protected:
+    void createPasswordLoginView() override;
+    std::unique_ptr<Wt::WWidget> createFormWidget(Wt::WFormModel::Field field) override;
+    std::unique_ptr<Wt::WWidget> createRegistrationView(const Wt::Auth::Identity& id) override;
+    std::unique_ptr<Wt::WWidget> createUpdatePasswordView(const Wt::Auth::User& user, bool promptPassword) override;
+
+private:
+    void attempt_password_login();
+    void finish_password_login(bool verified);
+    // What AuthModel::updateThrottling does, with the delay of the check done on the pool;
+    // the model only knows the delay of checks it ran itself.
+    void update_throttling(int delay);
+
+    worker_pool& password_workers_;
+    // Cleared when the login view goes away while a check is still running.
+    Wt::Core::observing_ptr<Wt::WPushButton> login_button_;
+    bool verifying_ = false;
+    std::string verifying_user_id_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_ASYNC_AUTH_WIDGET_HPP_
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "bearer_token.hpp"
+
+#include <sstream>
+
+#include "configuration.hpp"
+#include "csv.hpp"
+
+namespace
+{
+
+bool constant_time_equal(const std::string& left, const std::string& right)
+{
+    if (left.size() != right.size())
+    {
+        return false;
+    }
+    unsigned char difference = 0;
+    for (std::size_t i = 0; i < left.size(); ++i)
+    {
+        difference |= static_cast<unsigned char>(left[i] ^ right[i]);
+    }
+    return difference == 0;
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+std::vector<std::string> load_bearer_tokens(const Wt::WServer& server)
+{
+    std::vector<std::string> tokens;
+    std::string list;
+    if (!configuration::read_setting(server, "AGROMASTER_INGEST_TOKENS", "agromaster-ingest-tokens", list))
+    {
+        return tokens;
+    }
+
+    std::istringstream in(list);
+    std::string token;
+    while (std::getline(in, token, ','))
+    {
+        token = csv_trimmed(token);
+        if (!token.empty())
+        {
+            tokens.push_back(token);
+        }
+    }
+    return tokens;
+}
+
+bool has_bearer_token(const Wt::Http::Request& request, const std::vector<std::string>& tokens)
+{
+    static const std::string scheme = "Bearer ";
+    const std::string header = request.headerValue("Authorization");
+    if (header.compare(0, scheme.size(), scheme) != 0)
+    {
+        return false;
+    }
+
+    const std::string token = csv_trimmed(header.substr(scheme.size()));
+    bool known = false;
+    for (const std::string& configured : tokens)
+    {
+        known = constant_time_equal(token, configured) || known;
+    }
+    return known;
+}
+
+} // agromaster
\ No newline at end of file
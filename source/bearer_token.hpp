@@ -0,0 +1,23 @@
+#pragma once
+#ifndef AGROMASTER_BEARER_TOKEN_HPP_
+#define AGROMASTER_BEARER_TOKEN_HPP_
+
+#include <string>
+#include <vector>
+
+#include <Wt/Http/Request.h>
+#include <Wt/WServer.h>
+
+namespace agromaster
+{
+
+// Tokens machine clients may send as "Authorization: Bearer <token>", from the comma
+// separated ingest tokens setting.
+std::vector<std::string> load_bearer_tokens(const Wt::WServer& server);
+
+// Whether the request carries one of the tokens; compares in constant time.
+bool has_bearer_token(const Wt::Http::Request& request, const std::vector<std::string>& tokens);
+
+} // agromaster
+
+#endif // AGROMASTER_BEARER_TOKEN_HPP_
\ No newline at end of file
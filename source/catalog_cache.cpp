@@ -0,0 +1,195 @@
+#include "catalog_cache.hpp"
+
+namespace
+{
+
+constexpr char crops_key[] = "crops";
+constexpr char hothouses_count_key[] = "hothouses_count";
+
+std::string page_load_key(const char* kind, long long boundary, int limit)
+{
+    return std::string(kind) + ':' + std::to_string(boundary) + ':' + std::to_string(limit);
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+catalog_cache& catalog_cache::instance()
+{
+    static catalog_cache cache;
+    return cache;
+}
+
+std::uint64_t catalog_cache::version() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return version_;
+}
+
+void catalog_cache::invalidate()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++version_;
+    crops_.reset();
+    hothouses_count_ = -1;
+    hothouse_pages_after_.clear();
+    hothouse_pages_from_.clear();
+    load_mutexes_.clear();
+}
+
+catalog_cache::crops_type catalog_cache::crops(models::session& session)
+{
+    std::shared_ptr<std::mutex> load_mutex;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (crops_)
+        {
+            return crops_;
+        }
+        load_mutex = this->load_mutex(crops_key);
+    }
+
+    std::lock_guard<std::mutex> load_lock(*load_mutex);
+    std::uint64_t loaded_version = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (crops_)
+        {
+            return crops_;
+        }
+        loaded_version = version_;
+    }
+
+    crops_type crops;
+    {
+        Wt::Dbo::Transaction transaction(session);
+        crops = std::make_shared<std::vector<models::crop_summary>>(session.crop_summaries());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loaded_version == version_)
+    {
+        crops_ = crops;
+    }
+    return crops;
+}
+
+catalog_cache::hothouses_type catalog_cache::hothouses_after(models::session& session, long long after_id, int limit)
+{
+    return hothouses_page(hothouse_pages_after_, page_key(after_id, limit), page_load_key("after", after_id, limit),
+        session,
+        [&session, after_id, limit]
+    {
+        return session.hothouse_summaries_after(after_id, limit);
+    });
+}
+
+catalog_cache::hothouses_type catalog_cache::hothouses_from(models::session& session, int offset, int limit)
+{
+    return hothouses_page(hothouse_pages_from_, page_key(offset, limit), page_load_key("from", offset, limit),
+        session,
+        [&session, offset, limit]
+    {
+        return session.hothouse_summaries_from(offset, limit);
+    });
+}
+
+int catalog_cache::hothouses_count(models::session& session)
+{
+    std::shared_ptr<std::mutex> load_mutex;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (hothouses_count_ >= 0)
+        {
+            return hothouses_count_;
+        }
+        load_mutex = this->load_mutex(hothouses_count_key);
+    }
+
+    std::lock_guard<std::mutex> load_lock(*load_mutex);
+    std::uint64_t loaded_version = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (hothouses_count_ >= 0)
+        {
+            return hothouses_count_;
+        }
+        loaded_version = version_;
+    }
+
+    int count = 0;
+    {
+        Wt::Dbo::Transaction transaction(session);
+        count = session.hothouses_count();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loaded_version == version_)
+    {
+        hothouses_count_ = count;
+    }
+    return count;
+}
+
+catalog_cache::hothouses_type catalog_cache::hothouses_page(
+    std::map<page_key, hothouses_type>& pages,
+    const page_key& key,
+    const std::string& load_key,
+    models::session& session,
+    const std::function<std::vector<models::hothouse_summary>()>& load)
+{
+    std::shared_ptr<std::mutex> load_mutex;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto page = pages.find(key);
+        if (page != pages.end())
+        {
+            return page->second;
+        }
+        load_mutex = this->load_mutex(load_key);
+    }
+
+    std::lock_guard<std::mutex> load_lock(*load_mutex);
+    std::uint64_t loaded_version = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto page = pages.find(key);
+        if (page != pages.end())
+        {
+            return page->second;
+        }
+        loaded_version = version_;
+    }
+
+    hothouses_type hothouses;
+    {
+        Wt::Dbo::Transaction transaction(session);
+        hothouses = std::make_shared<std::vector<models::hothouse_summary>>(load());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loaded_version == version_)
+    {
+        if (pages.size() >= max_hothouse_pages)
+        {
+            pages.clear();
+            load_mutexes_.clear();
+        }
+        pages.emplace(key, hothouses);
+    }
+    return hothouses;
+}
+
+std::shared_ptr<std::mutex> catalog_cache::load_mutex(const std::string& load_key)
+{
+    std::shared_ptr<std::mutex>& load_mutex = load_mutexes_[load_key];
+    if (!load_mutex)
+    {
+        load_mutex = std::make_shared<std::mutex>();
+    }
+    return load_mutex;
+}
+
+} // agromaster
\ No newline at end of file
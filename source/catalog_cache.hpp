@@ -0,0 +1,72 @@
+#pragma once
+#ifndef AGROMASTER_CATALOG_CACHE_HPP_
+#define AGROMASTER_CATALOG_CACHE_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "models.hpp"
+
+namespace agromaster
+{
+
+// Process wide read cache of the crop and hothouse catalog shared by all sessions.
+//
+// Entries are immutable snapshots handed out as shared pointers, so readers never hold
+// the lock while rendering. Every write bumps the version and drops all entries; a load
+// that started under an older version is returned to its caller but not cached. Each
+// entry is loaded by one thread at a time, outside the cache lock, so a burst of sessions
+// refreshing after the same write costs a single query per entry while misses of other
+// entries go ahead in parallel.
+class catalog_cache
+{
+public:
+    using crops_type = std::shared_ptr<const std::vector<models::crop_summary>>;
+    using hothouses_type = std::shared_ptr<const std::vector<models::hothouse_summary>>;
+
+    static constexpr std::size_t max_hothouse_pages = 1024;
+
+    static catalog_cache& instance();
+
+    std::uint64_t version() const;
+    void invalidate();
+
+    // The session is only used to load missing entries.
+    crops_type crops(models::session& session);
+    hothouses_type hothouses_after(models::session& session, long long after_id, int limit);
+    hothouses_type hothouses_from(models::session& session, int offset, int limit);
+    int hothouses_count(models::session& session);
+
+private:
+    using page_key = std::pair<long long, int>;
+
+    catalog_cache() = default;
+
+    hothouses_type hothouses_page(
+        std::map<page_key, hothouses_type>& pages,
+        const page_key& key,
+        const std::string& load_key,
+        models::session& session,
+        const std::function<std::vector<models::hothouse_summary>()>& load);
+    // Mutex serializing the loads of one entry. Called with mutex_ held.
+    std::shared_ptr<std::mutex> load_mutex(const std::string& load_key);
+
+    mutable std::mutex mutex_;
+    // Dropped with the entries; a thread still loading keeps its mutex alive.
+    std::map<std::string, std::shared_ptr<std::mutex>> load_mutexes_;
+    std::uint64_t version_ = 0;
+    crops_type crops_;
+    int hothouses_count_ = -1;
+    std::map<page_key, hothouses_type> hothouse_pages_after_;
+    std::map<page_key, hothouses_type> hothouse_pages_from_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_CATALOG_CACHE_HPP_
\ No newline at end of file
@@ -0,0 +1,350 @@
+#include "catalog_import.hpp"
+
+#include <map>
+#include <sstream>
+
+#include <Wt/Dbo/Exception.h>
+#include <Wt/Dbo/Transaction.h>
+
+#include "csv.hpp"
+#include "validation.hpp"
+
+namespace
+{
+
+constexpr char date_format[] = "yyyy-MM-dd";
+
+// Positions of the named columns of a file, from its header line.
+class columns
+{
+public:
+    explicit columns(const std::vector<std::string>& header)
+        : count_(header.size())
+    {
+        for (std::size_t i = 0; i < header.size(); ++i)
+        {
+            positions_.emplace(header[i], i);
+        }
+    }
+
+    bool has(const std::string& name) const
+    {
+        return positions_.count(name) > 0;
+    }
+
+    std::size_t count() const
+    {
+        return count_;
+    }
+
+    // Empty for a column the file does not have.
+    const std::string& get(const std::vector<std::string>& fields, const std::string& name) const
+    {
+        static const std::string none;
+        auto position = positions_.find(name);
+        return position == positions_.end() ? none : fields[position->second];
+    }
+
+private:
+    std::size_t count_;
+    std::map<std::string, std::size_t> positions_;
+};
+
+bool parse_date(const std::string& text, Wt::WDate& date)
+{
+    date = text.empty() ? Wt::WDate() : Wt::WDate::fromString(Wt::WString::fromUTF8(text), date_format);
+    return text.empty() || date.isValid();
+}
+
+// Reports the first invalid date through bad_date.
+bool parse_dates(const std::string& text, std::string& encoded, std::string& bad_date)
+{
+    std::set<Wt::WDate> dates;
+    std::istringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ';'))
+    {
+        item = agromaster::csv_trimmed(item);
+        if (item.empty())
+        {
+            continue;
+        }
+        Wt::WDate date;
+        if (!parse_date(item, date))
+        {
+            bad_date = item;
+            return false;
+        }
+        dates.insert(date);
+    }
+    encoded = agromaster::models::encode_dates(dates);
+    return true;
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+constexpr std::size_t catalog_import::max_reported_errors;
+
+void catalog_import::read(std::istream& in, const std::string& source)
+{
+    std::string line;
+    if (!std::getline(in, line))
+    {
+        add_error(source, 1, u8" ");
+        return;
+    }
+
+    // Spreadsheet applications and export_resource start UTF-8 files with a byte order mark.
+    if (line.compare(0, 3, "\xEF\xBB\xBF") == 0)
+    {
+        line.erase(0, 3);
+    }
+    const std::vector<std::string> header = split_csv_line(line);
+    const columns known(header);
+    if (!known.has("title"))
+    {
+        add_error(source, 1, u8"  title");
+        return;
+    }
+    if (known.has("crop"))
+    {
+        read_hothouses(in, source, header);
+    }
+    else
+    {
+        read_crops(in, source, header);
+    }
+}
+
+void catalog_import::read_crops(std::istream& in, const std::string& source, const std::vector<std::string>& header)
+{
+    // The hothouse totals of a crops export are ignored.
+    static const std::set<std::string> names{
+        "title", "sowing", "harvest", "fertilizer_dates", "watering_dates", "hothouses", "yields", "spent_fertilizers" };
+    for (const std::string& name : header)
+    {
+        if (!names.count(name))
+        {
+            add_error(source, 1, Wt::WString(u8"  {1}").arg(Wt::WString::fromUTF8(name)));
+        }
+    }
+
+    const columns known(header);
+    std::string line;
+    for (std::size_t number = 2; std::getline(in, line); ++number)
+    {
+        if (csv_trimmed(line).empty())
+        {
+            continue;
+        }
+        const std::vector<std::string> fields = split_csv_line(line);
+        if (fields.size() != known.count())
+        {
+            add_error(source, number, Wt::WString(u8" : {1}").arg(static_cast<int>(known.count())));
+            continue;
+        }
+
+        pending_crop crop;
+        crop.source = source;
+        crop.line = number;
+        crop.record.title = known.get(fields, "title");
+        const Wt::WString title = Wt::WString::fromUTF8(crop.record.title);
+        std::string bad_date;
+        if (crop.record.title.empty())
+        {
+            add_error(source, number, u8" ");
+        }
+        else if (title.value().size() > max_title_length)
+        {
+            add_error(source, number, u8"  30 ");
+        }
+        else if (!crop_titles_.insert(crop.record.title).second)
+        {
+            add_error(source, number, Wt::WString(u8" {1}    ").arg(title));
+        }
+        else if (!parse_date(known.get(fields, "sowing"), crop.record.sowing) ||
+            !parse_date(known.get(fields, "harvest"), crop.record.harvest))
+        {
+            add_error(source, number, u8"    ");
+        }
+        else if (!parse_dates(known.get(fields, "fertilizer_dates"), crop.record.fertilizer_dates, bad_date) ||
+            !parse_dates(known.get(fields, "watering_dates"), crop.record.watering_dates, bad_date))
+        {
+            add_error(source, number, Wt::WString(u8"  {1}").arg(Wt::WString::fromUTF8(bad_date)));
+        }
+        else
+        {
+            crops_.push_back(std::move(crop));
+        }
+    }
+}
+
+void catalog_import::read_hothouses(std::istream& in, const std::string& source, const std::vector<std::string>& header)
+{
+    static const std::set<std::string> names{
+        "title", "crop", "yields", "spent_fertilizers", "sowing", "harvest", "fertilizer_dates", "watering_dates" };
+    for (const std::string& name : header)
+    {
+        if (!names.count(name))
+        {
+            add_error(source, 1, Wt::WString(u8"  {1}").arg(Wt::WString::fromUTF8(name)));
+        }
+    }
+
+    const columns known(header);
+    std::string line;
+    for (std::size_t number = 2; std::getline(in, line); ++number)
+    {
+        if (csv_trimmed(line).empty())
+        {
+            continue;
+        }
+        const std::vector<std::string> fields = split_csv_line(line);
+        if (fields.size() != known.count())
+        {
+            add_error(source, number, Wt::WString(u8" : {1}").arg(static_cast<int>(known.count())));
+            continue;
+        }
+
+        pending_hothouse hothouse;
+        hothouse.source = source;
+        hothouse.line = number;
+        hothouse.crop_title = known.get(fields, "crop");
+        models::hothouse_record& record = hothouse.record;
+        record.title = known.get(fields, "title");
+        const Wt::WString title = Wt::WString::fromUTF8(record.title);
+        std::string bad_date;
+        if (record.title.empty())
+        {
+            add_error(source, number, u8" ");
+        }
+        else if (title.value().size() > max_title_length)
+        {
+            add_error(source, number, u8"  30 ");
+        }
+        else if (!hothouse_titles_.insert(record.title).second)
+        {
+            add_error(source, number, Wt::WString(u8" {1}    ").arg(title));
+        }
+        else if (!parse_quantity(known.get(fields, "yields"), record.yields) ||
+            !parse_quantity(known.get(fields, "spent_fertilizers"), record.spent_fertilizers))
+        {
+            add_error(source, number, u8"    ");
+        }
+        else if (!parse_date(known.get(fields, "sowing"), record.sowing) ||
+            !parse_date(known.get(fields, "harvest"), record.harvest))
+        {
+            add_error(source, number, u8"    ");
+        }
+        else if (!parse_dates(known.get(fields, "fertilizer_dates"), record.fertilizer_dates, bad_date) ||
+            !parse_dates(known.get(fields, "watering_dates"), record.watering_dates, bad_date))
+        {
+            add_error(source, number, Wt::WString(u8"  {1}").arg(Wt::WString::fromUTF8(bad_date)));
+        }
+        else
+        {
+            hothouses_.push_back(std::move(hothouse));
+        }
+    }
+}
+
+catalog_import::report catalog_import::run(models::session& session)
+{
+    report result;
+    try
+    {
+        Wt::Dbo::Transaction transaction(session);
+
+        const std::map<std::string, long long> existing_crops = session.crop_ids_by_title();
+        for (const pending_crop& crop : crops_)
+        {
+            if (existing_crops.count(crop.record.title))
+            {
+                add_error(crop.source, crop.line, Wt::WString(u8" {1}  ")
+                    .arg(Wt::WString::fromUTF8(crop.record.title)));
+            }
+        }
+
+        const std::map<std::string, long long> existing_hothouses = session.hothouse_ids_by_title(
+            std::vector<std::string>(hothouse_titles_.begin(), hothouse_titles_.end()));
+        for (const pending_hothouse& hothouse : hothouses_)
+        {
+            if (existing_hothouses.count(hothouse.record.title))
+            {
+                add_error(hothouse.source, hothouse.line, Wt::WString(u8" {1}  ")
+                    .arg(Wt::WString::fromUTF8(hothouse.record.title)));
+            }
+            else if (!hothouse.crop_title.empty() &&
+                !crop_titles_.count(hothouse.crop_title) && !existing_crops.count(hothouse.crop_title))
+            {
+                add_error(hothouse.source, hothouse.line, Wt::WString(u8"  {1}")
+                    .arg(Wt::WString::fromUTF8(hothouse.crop_title)));
+            }
+        }
+
+        if (error_count_ == 0)
+        {
+            std::vector<models::crop_record> crops;
+            crops.reserve(crops_.size());
+            for (const pending_crop& crop : crops_)
+            {
+                crops.push_back(crop.record);
+            }
+            const std::map<std::string, long long> crop_ids = session.insert_crops(crops);
+
+            std::vector<models::hothouse_record> hothouses;
+            hothouses.reserve(hothouses_.size());
+            for (const pending_hothouse& hothouse : hothouses_)
+            {
+                hothouses.push_back(hothouse.record);
+                if (hothouse.crop_title.empty())
+                {
+                    continue;
+                }
+                auto imported = crop_ids.find(hothouse.crop_title);
+                hothouses.back().crop_id =
+                    imported != crop_ids.end() ? imported->second : existing_crops.at(hothouse.crop_title);
+                result.changes.change_crop(hothouses.back().crop_id);
+            }
+            const std::map<std::string, long long> hothouse_ids = session.insert_hothouses(hothouses);
+            transaction.commit();
+
+            result.crops = crop_ids.size();
+            result.hothouses = hothouse_ids.size();
+            for (const auto& crop : crop_ids)
+            {
+                result.changes.added_crops.insert(crop.second);
+                result.changes.changed_crops.erase(crop.second);
+            }
+            for (const auto& hothouse : hothouse_ids)
+            {
+                result.changes.added_hothouses.insert(hothouse.second);
+            }
+        }
+    }
+    catch (const Wt::Dbo::Exception& failure)
+    {
+        add_error(std::string(), 0, Wt::WString(u8"  : {1}").arg(Wt::WString::fromUTF8(failure.what())));
+        result.crops = 0;
+        result.hothouses = 0;
+        result.changes = change_set();
+    }
+
+    result.errors = errors_;
+    result.error_count = error_count_;
+    return result;
+}
+
+void catalog_import::add_error(const std::string& source, std::size_t line, const Wt::WString& message)
+{
+    if (errors_.size() < max_reported_errors)
+    {
+        errors_.push_back(error{ source, line, message });
+    }
+    ++error_count_;
+}
+
+} // agromaster
\ No newline at end of file
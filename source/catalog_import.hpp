@@ -0,0 +1,89 @@
+#pragma once
+#ifndef AGROMASTER_CATALOG_IMPORT_HPP_
+#define AGROMASTER_CATALOG_IMPORT_HPP_
+
+#include <cstddef>
+#include <istream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Wt/WString.h>
+
+#include "change_set.hpp"
+#include "models.hpp"
+
+namespace agromaster
+{
+
+// Bulk load of a farm catalog from CSV files, for onboarding.
+//
+// A crops file has the columns title, sowing, harvest, fertilizer_dates and
+// watering_dates; a hothouses file has title, crop, yields, spent_fertilizers, sowing,
+// harvest, fertilizer_dates and watering_dates. Only title, and crop for hothouses, are
+// required; the header line names the columns in any order, and the crop column tells the
+// two kinds apart. Dates are yyyy-MM-dd, date lists are separated by ';'. A hothouse crop
+// names a crop of the same import or one already in the database. Files written by
+// export_resource read back unchanged.
+//
+// Files are read line by line into memory. run() then checks the titles and crop
+// references against the database with a handful of queries and, only when nothing is
+// wrong, inserts everything in one transaction with multi-row inserts.
+class catalog_import
+{
+public:
+    struct error
+    {
+        std::string source;
+        std::size_t line = 0;
+        Wt::WString message;
+    };
+
+    struct report
+    {
+        std::size_t crops = 0;
+        std::size_t hothouses = 0;
+        // At most max_reported_errors; error_count has the total.
+        std::vector<error> errors;
+        std::size_t error_count = 0;
+        change_set changes;
+    };
+
+    static constexpr std::size_t max_reported_errors = 100;
+
+    // Problems are recorded for the report instead of thrown.
+    void read(std::istream& in, const std::string& source);
+
+    report run(models::session& session);
+
+private:
+    struct pending_crop
+    {
+        models::crop_record record;
+        std::string source;
+        std::size_t line = 0;
+    };
+
+    struct pending_hothouse
+    {
+        models::hothouse_record record;
+        std::string crop_title;
+        std::string source;
+        std::size_t line = 0;
+    };
+
+    void read_crops(std::istream& in, const std::string& source, const std::vector<std::string>& header);
+    void read_hothouses(std::istream& in, const std::string& source, const std::vector<std::string>& header);
+    void add_error(const std::string& source, std::size_t line, const Wt::WString& message);
+
+    std::vector<pending_crop> crops_;
+    std::vector<pending_hothouse> hothouses_;
+    std::set<std::string> crop_titles_;
+    std::set<std::string> hothouse_titles_;
+    std::vector<error> errors_;
+    std::size_t error_count_ = 0;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_CATALOG_IMPORT_HPP_
\ No newline at end of file
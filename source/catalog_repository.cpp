@@ -0,0 +1,332 @@
+#include "catalog_repository.hpp"
+
+#include <Wt/Dbo/Transaction.h>
+
+#include "connection_pool.hpp"
+
+namespace
+{
+
+template <class C>
+Wt::Dbo::ptr<C> find_by_id(agromaster::models::session& session, long long id)
+{
+    return session.find<C>().where("id = ?").bind(id);
+}
+
+template <class C>
+Wt::Dbo::ptr<C> find_by_title(agromaster::models::session& session, const std::string& title)
+{
+    return session.find<C>().where("title = ?").bind(title).limit(1);
+}
+
+// Sets field to value unless they are equal already, so unchanged rows are not written.
+template <class C, class T>
+void assign(Wt::Dbo::ptr<C>& object, T C::*field, const T& value)
+{
+    if ((*object).*field != value)
+    {
+        object.modify()->*field = value;
+    }
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+catalog_repository::catalog_repository(models::session& session)
+    : session_(session)
+{
+}
+
+enum models::user_account::role catalog_repository::user_role()
+{
+    Wt::Dbo::Transaction transaction(session_);
+    return session_.user_role();
+}
+
+catalog_cache::crops_type catalog_repository::crops()
+{
+    return catalog_cache::instance().crops(session_);
+}
+
+std::vector<models::hothouse_summary> catalog_repository::hothouses(const std::set<long long>& ids)
+{
+    Wt::Dbo::Transaction transaction(session_);
+    return session_.hothouse_summaries(ids);
+}
+
+catalog_cache::hothouses_type catalog_repository::hothouses_after(long long after_id, int limit)
+{
+    return catalog_cache::instance().hothouses_after(session_, after_id, limit);
+}
+
+catalog_cache::hothouses_type catalog_repository::hothouses_from(int offset, int limit)
+{
+    return catalog_cache::instance().hothouses_from(session_, offset, limit);
+}
+
+int catalog_repository::hothouses_count()
+{
+    return catalog_cache::instance().hothouses_count(session_);
+}
+
+bool catalog_repository::hothouse_works(long long hothouse_id, models::season_dates& works)
+{
+    Wt::Dbo::Transaction transaction(session_);
+    return session_.hothouse_works(hothouse_id, works);
+}
+
+bool catalog_repository::crop_schedules(long long crop_id, models::season_dates& schedules)
+{
+    Wt::Dbo::Transaction transaction(session_);
+    return session_.crop_schedules(crop_id, schedules);
+}
+
+catalog_repository::outcome catalog_repository::add_hothouse(
+    const std::string& title,
+    long long crop_id,
+    change_set& changes)
+{
+    const connection_pool::admission admission(connection_pool::priority::edit);
+    Wt::Dbo::Transaction transaction(session_);
+    if (find_by_title<models::hothouse>(session_, title))
+    {
+        return outcome::title_taken;
+    }
+
+    Wt::Dbo::ptr<models::crop> crop;
+    if (crop_id)
+    {
+        crop = find_by_id<models::crop>(session_, crop_id);
+        if (!crop)
+        {
+            return outcome::not_found;
+        }
+    }
+
+    auto hothouse = session_.addNew<models::hothouse>();
+    hothouse.modify()->title = title;
+    hothouse.modify()->works = session_.addNew<models::works>();
+    if (crop)
+    {
+        hothouse.modify()->crop = crop;
+        crop.modify()->hothouses.insert(hothouse);
+    }
+    hothouse.flush();
+    transaction.commit();
+
+    changes.added_hothouses.insert(hothouse.id());
+    changes.change_crop(crop_id);
+    return outcome::done;
+}
+
+catalog_repository::outcome catalog_repository::change_hothouse(
+    long long hothouse_id,
+    const std::string& new_title,
+    long long new_crop_id,
+    double new_yields,
+    double new_spent_fertilizers,
+    change_set& changes)
+{
+    const connection_pool::admission admission(connection_pool::priority::edit);
+    Wt::Dbo::Transaction transaction(session_);
+    Wt::Dbo::ptr<models::hothouse> hothouse = find_by_id<models::hothouse>(session_, hothouse_id);
+    if (!hothouse)
+    {
+        return outcome::not_found;
+    }
+    const bool renamed = !new_title.empty() && hothouse->title != new_title;
+    if (renamed && find_by_title<models::hothouse>(session_, new_title))
+    {
+        return outcome::title_taken;
+    }
+
+    Wt::Dbo::ptr<models::crop> new_crop;
+    if (new_crop_id)
+    {
+        new_crop = find_by_id<models::crop>(session_, new_crop_id);
+        if (!new_crop)
+        {
+            return outcome::not_found;
+        }
+    }
+
+    const long long old_crop_id = hothouse->crop ? hothouse->crop.id() : 0;
+    if (renamed)
+    {
+        hothouse.modify()->title = new_title;
+    }
+    assign(hothouse, &models::hothouse::yields, new_yields);
+    assign(hothouse, &models::hothouse::spent_fertilizers, new_spent_fertilizers);
+    if (old_crop_id != new_crop_id)
+    {
+        if (hothouse->crop)
+        {
+            hothouse->crop.modify()->hothouses.erase(hothouse);
+        }
+        hothouse.modify()->crop = new_crop;
+        if (new_crop)
+        {
+            new_crop.modify()->hothouses.insert(hothouse);
+        }
+    }
+    transaction.commit();
+
+    changes.changed_hothouses.insert(hothouse_id);
+    changes.change_crop(old_crop_id);
+    changes.change_crop(new_crop_id);
+    return outcome::done;
+}
+
+catalog_repository::outcome catalog_repository::change_hothouse_works(
+    long long hothouse_id,
+    const models::season_dates& works)
+{
+    const connection_pool::admission admission(connection_pool::priority::edit);
+    Wt::Dbo::Transaction transaction(session_);
+    Wt::Dbo::ptr<models::hothouse> hothouse = find_by_id<models::hothouse>(session_, hothouse_id);
+    Wt::Dbo::ptr<models::works> stored = hothouse ? hothouse->works.lock() : Wt::Dbo::ptr<models::works>();
+    if (!stored)
+    {
+        return outcome::not_found;
+    }
+
+    assign(stored, &models::works::sowing_work, works.sowing);
+    assign(stored, &models::works::harvest_work, works.harvest);
+    assign(stored, &models::works::fertilizer_dates, models::encode_dates(works.fertilizer_dates));
+    assign(stored, &models::works::watering_dates, models::encode_dates(works.watering_dates));
+    transaction.commit();
+    return outcome::done;
+}
+
+catalog_repository::outcome catalog_repository::delete_hothouse(long long hothouse_id, change_set& changes)
+{
+    const connection_pool::admission admission(connection_pool::priority::edit);
+    Wt::Dbo::Transaction transaction(session_);
+    Wt::Dbo::ptr<models::hothouse> hothouse = find_by_id<models::hothouse>(session_, hothouse_id);
+    if (!hothouse)
+    {
+        return outcome::not_found;
+    }
+
+    const long long crop_id = hothouse->crop ? hothouse->crop.id() : 0;
+    hothouse.remove();
+    transaction.commit();
+
+    changes.removed_hothouses.insert(hothouse_id);
+    changes.change_crop(crop_id);
+    return outcome::done;
+}
+
+catalog_repository::outcome catalog_repository::add_crop(const std::string& title, change_set& changes)
+{
+    const connection_pool::admission admission(connection_pool::priority::edit);
+    Wt::Dbo::Transaction transaction(session_);
+    if (find_by_title<models::crop>(session_, title))
+    {
+        return outcome::title_taken;
+    }
+
+    auto crop = session_.addNew<models::crop>();
+    crop.modify()->title = title;
+    crop.modify()->schedules = session_.addNew<models::schedules>();
+    crop.flush();
+    transaction.commit();
+
+    changes.added_crops.insert(crop.id());
+    return outcome::done;
+}
+
+catalog_repository::outcome catalog_repository::rename_crop(
+    long long crop_id,
+    const std::string& new_title,
+    change_set& changes)
+{
+    const connection_pool::admission admission(connection_pool::priority::edit);
+    Wt::Dbo::Transaction transaction(session_);
+    Wt::Dbo::ptr<models::crop> crop = find_by_id<models::crop>(session_, crop_id);
+    if (!crop)
+    {
+        return outcome::not_found;
+    }
+    Wt::Dbo::ptr<models::crop> existing_crop = find_by_title<models::crop>(session_, new_title);
+    if (existing_crop && existing_crop != crop)
+    {
+        return outcome::title_taken;
+    }
+
+    crop.modify()->title = new_title;
+    transaction.commit();
+
+    changes.change_crop(crop_id);
+    return outcome::done;
+}
+
+catalog_repository::outcome catalog_repository::change_crop_schedules(
+    long long crop_id,
+    const models::season_dates& schedules)
+{
+    const connection_pool::admission admission(connection_pool::priority::edit);
+    Wt::Dbo::Transaction transaction(session_);
+    Wt::Dbo::ptr<models::crop> crop = find_by_id<models::crop>(session_, crop_id);
+    Wt::Dbo::ptr<models::schedules> stored = crop ? crop->schedules.lock() : Wt::Dbo::ptr<models::schedules>();
+    if (!stored)
+    {
+        return outcome::not_found;
+    }
+
+    assign(stored, &models::schedules::sowing_schedule, schedules.sowing);
+    assign(stored, &models::schedules::harvest_schedule, schedules.harvest);
+    assign(stored, &models::schedules::fertilizer_dates, models::encode_dates(schedules.fertilizer_dates));
+    assign(stored, &models::schedules::watering_dates, models::encode_dates(schedules.watering_dates));
+    transaction.commit();
+    return outcome::done;
+}
+
+catalog_repository::outcome catalog_repository::delete_crop(long long crop_id, change_set& changes)
+{
+    const connection_pool::admission admission(connection_pool::priority::edit);
+    Wt::Dbo::Transaction transaction(session_);
+    Wt::Dbo::ptr<models::crop> crop = find_by_id<models::crop>(session_, crop_id);
+    if (!crop)
+    {
+        return outcome::not_found;
+    }
+
+    crop.remove();
+    transaction.commit();
+
+    changes.removed_crops.insert(crop_id);
+    return outcome::done;
+}
+
+catalog_import::report catalog_repository::import_catalog(catalog_import& import)
+{
+    const connection_pool::admission admission(connection_pool::priority::bulk);
+    return import.run(session_);
+}
+
+std::vector<models::hothouse_export> catalog_repository::hothouse_exports_after(
+    Wt::Dbo::SqlConnectionPool& connection_pool,
+    long long after_id,
+    int limit)
+{
+    const connection_pool::admission admission(connection_pool::priority::bulk);
+    models::session session(connection_pool);
+    Wt::Dbo::Transaction transaction(session);
+    return session.hothouse_exports_after(after_id, limit);
+}
+
+std::vector<models::crop_export> catalog_repository::crop_exports_after(
+    Wt::Dbo::SqlConnectionPool& connection_pool,
+    long long after_id,
+    int limit)
+{
+    const connection_pool::admission admission(connection_pool::priority::bulk);
+    models::session session(connection_pool);
+    Wt::Dbo::Transaction transaction(session);
+    return session.crop_exports_after(after_id, limit);
+}
+
+} // agromaster
\ No newline at end of file
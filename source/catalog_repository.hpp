@@ -0,0 +1,93 @@
+#pragma once
+#ifndef AGROMASTER_CATALOG_REPOSITORY_HPP_
+#define AGROMASTER_CATALOG_REPOSITORY_HPP_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Wt/Dbo/SqlConnectionPool.h>
+
+#include "catalog_cache.hpp"
+#include "catalog_import.hpp"
+#include "change_set.hpp"
+#include "models.hpp"
+
+namespace agromaster
+{
+
+// The only way the UI reaches the catalog: the pages, dialogs, table models, the CSV
+// import and the CSV export all go through it. Only Wt::Auth touches the database
+// besides, through the user database of the session.
+//
+// Every call runs in its own transaction, which is committed or rolled back before the
+// call returns, and hands out plain values instead of Dbo pointers. Views fetch everything
+// a dialog or a table needs first and build their widgets afterwards, so a connection of
+// the pool is never held while widgets are created. Edits are admitted to the pool ahead
+// of reads and bulk work.
+class catalog_repository
+{
+public:
+    enum class outcome
+    {
+        done,
+        title_taken,
+        not_found,
+    };
+
+    explicit catalog_repository(models::session& session);
+
+    // Resolves the account of the logged in user; login_name() of the session is then
+    // cached and needs no transaction.
+    enum models::user_account::role user_role();
+
+    catalog_cache::crops_type crops();
+    std::vector<models::hothouse_summary> hothouses(const std::set<long long>& ids);
+    // Pages of the hothouse table, through the catalog_cache shared by the sessions.
+    catalog_cache::hothouses_type hothouses_after(long long after_id, int limit);
+    catalog_cache::hothouses_type hothouses_from(int offset, int limit);
+    int hothouses_count();
+
+    // Return false when the hothouse or the crop is gone.
+    bool hothouse_works(long long hothouse_id, models::season_dates& works);
+    bool crop_schedules(long long crop_id, models::season_dates& schedules);
+
+    // The edits record the rows they touch in changes; nothing is recorded unless they
+    // return outcome::done. An empty new title keeps the current one.
+    outcome add_hothouse(const std::string& title, long long crop_id, change_set& changes);
+    outcome change_hothouse(
+        long long hothouse_id,
+        const std::string& new_title,
+        long long new_crop_id,
+        double new_yields,
+        double new_spent_fertilizers,
+        change_set& changes);
+    outcome change_hothouse_works(long long hothouse_id, const models::season_dates& works);
+    outcome delete_hothouse(long long hothouse_id, change_set& changes);
+    outcome add_crop(const std::string& title, change_set& changes);
+    outcome rename_crop(long long crop_id, const std::string& new_title, change_set& changes);
+    outcome change_crop_schedules(long long crop_id, const models::season_dates& schedules);
+    outcome delete_crop(long long crop_id, change_set& changes);
+
+    // Loads the files read by import, admitted to the pool as bulk work.
+    catalog_import::report import_catalog(catalog_import& import);
+
+    // Chunks of the CSV export, admitted to the pool as bulk work. export_resource serves
+    // downloads outside the session lock, so these take the pool and read through a
+    // session of their own rather than the one of the UI.
+    static std::vector<models::hothouse_export> hothouse_exports_after(
+        Wt::Dbo::SqlConnectionPool& connection_pool,
+        long long after_id,
+        int limit);
+    static std::vector<models::crop_export> crop_exports_after(
+        Wt::Dbo::SqlConnectionPool& connection_pool,
+        long long after_id,
+        int limit);
+
+private:
+    models::session& session_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_CATALOG_REPOSITORY_HPP_
\ No newline at end of file
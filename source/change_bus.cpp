@@ -0,0 +1,69 @@
+#include "change_bus.hpp"
+
+#include <utility>
+#include <vector>
+
+#include <Wt/WServer.h>
+
+namespace agromaster
+{
+
+change_bus& change_bus::instance()
+{
+    static change_bus bus;
+    return bus;
+}
+
+void change_bus::subscribe(const std::string& key, const std::string& session_id, handler_type handler)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_[key] = subscriber{ session_id, std::move(handler) };
+}
+
+void change_bus::move_session(const std::string& key, const std::string& session_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = subscribers_.find(key);
+    if (found != subscribers_.end())
+    {
+        found->second.session_id = session_id;
+    }
+}
+
+void change_bus::unsubscribe(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_.erase(key);
+}
+
+void change_bus::publish(const change_set& changes, const std::string& origin_key)
+{
+    Wt::WServer* server = Wt::WServer::instance();
+    if (!server || changes.empty())
+    {
+        return;
+    }
+
+    std::vector<subscriber> recipients;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& keyed : subscribers_)
+        {
+            if (keyed.first != origin_key)
+            {
+                recipients.push_back(keyed.second);
+            }
+        }
+    }
+
+    for (const subscriber& recipient : recipients)
+    {
+        server->post(recipient.session_id,
+            [handler = recipient.handler, changes]
+        {
+            handler(changes);
+        });
+    }
+}
+
+} // agromaster
\ No newline at end of file
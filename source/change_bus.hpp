@@ -0,0 +1,50 @@
+#pragma once
+#ifndef AGROMASTER_CHANGE_BUS_HPP_
+#define AGROMASTER_CHANGE_BUS_HPP_
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "change_set.hpp"
+
+namespace agromaster
+{
+
+// In-process publish/subscribe channel for committed catalog edits.
+//
+// Sessions subscribe under a key of their own with their session id and a handler;
+// publish() hands the change set to every other subscriber through Wt::WServer::post, so
+// each handler runs inside its own session and may touch its widgets. A handler is never
+// called after its session is gone. Wt gives a session a new id at login, so the key has
+// to be stable and the subscriber reports the new id through move_session().
+class change_bus
+{
+public:
+    using handler_type = std::function<void(const change_set&)>;
+
+    static change_bus& instance();
+
+    void subscribe(const std::string& key, const std::string& session_id, handler_type handler);
+    void move_session(const std::string& key, const std::string& session_id);
+    void unsubscribe(const std::string& key);
+    void publish(const change_set& changes, const std::string& origin_key);
+
+private:
+    struct subscriber
+    {
+        std::string session_id;
+        handler_type handler;
+    };
+
+    change_bus() = default;
+
+    std::mutex mutex_;
+    // By key.
+    std::map<std::string, subscriber> subscribers_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_CHANGE_BUS_HPP_
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef AGROMASTER_CHANGE_SET_HPP_
+#define AGROMASTER_CHANGE_SET_HPP_
+
+#include <set>
+
+namespace agromaster
+{
+
+// Ids of the rows touched by one edit. Views patch exactly these rows instead of
+// rebuilding their tables. Crops are listed as changed whenever their title or any
+// of their hothouse aggregates may have changed.
+struct change_set
+{
+    std::set<long long> added_hothouses;
+    std::set<long long> changed_hothouses;
+    std::set<long long> removed_hothouses;
+    std::set<long long> added_crops;
+    std::set<long long> changed_crops;
+    std::set<long long> removed_crops;
+
+    void change_crop(long long id)
+    {
+        if (id > 0)
+        {
+            changed_crops.insert(id);
+        }
+    }
+
+    bool empty() const
+    {
+        return added_hothouses.empty() && changed_hothouses.empty() && removed_hothouses.empty()
+            && added_crops.empty() && changed_crops.empty() && removed_crops.empty();
+    }
+};
+
+} // agromaster
+
+#endif // AGROMASTER_CHANGE_SET_HPP_
\ No newline at end of file
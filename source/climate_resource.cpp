@@ -0,0 +1,265 @@
+#include "climate_resource.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <istream>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+#include <Wt/Dbo/Transaction.h>
+
+#include "bearer_token.hpp"
+#include "connection_pool.hpp"
+
+namespace
+{
+
+using agromaster::models::climate_metric;
+using agromaster::models::climate_resolution;
+
+// Lines past this many are refused with 413.
+constexpr std::size_t max_points = 100000;
+
+// Errors listed in a 400 response; the rest are only counted.
+constexpr std::size_t max_reported_errors = 20;
+
+// 2000-01-01; older times are taken for unset sensor clocks.
+constexpr long long earliest_time = 946684800;
+
+// Sensor clocks may run this far ahead of the server.
+constexpr long long max_clock_skew = 24 * 3600;
+
+constexpr char expected_header[] = "hothouse_id,metric,measured_at,value";
+
+bool parse_metric(const std::string& name, climate_metric& metric)
+{
+    static const std::pair<const char*, climate_metric> metrics[] =
+    {
+        { "temperature", climate_metric::temperature },
+        { "humidity", climate_metric::humidity },
+        { "co2", climate_metric::co2 },
+        { "soil_moisture", climate_metric::soil_moisture },
+    };
+    for (const auto& known : metrics)
+    {
+        if (name == known.first)
+        {
+            metric = known.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_resolution(const std::string& name, climate_resolution& resolution)
+{
+    if (name == "hourly")
+    {
+        resolution = climate_resolution::hourly;
+        return true;
+    }
+    if (name == "daily")
+    {
+        resolution = climate_resolution::daily;
+        return true;
+    }
+    return false;
+}
+
+bool parse_integer(const std::string& text, long long& number)
+{
+    char* end = nullptr;
+    number = std::strtoll(text.c_str(), &end, 10);
+    return !text.empty() && end == text.c_str() + text.size();
+}
+
+bool parse_value(const std::string& text, double& value)
+{
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && end == text.c_str() + text.size() && std::isfinite(value);
+}
+
+void reply(Wt::Http::Response& response, int status, const std::string& body)
+{
+    response.setStatus(status);
+    response.setMimeType("text/plain; charset=utf-8");
+    response.out() << body << '\n';
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+constexpr long long climate_resource::max_buckets;
+
+climate_resource::climate_resource(
+    climate_writer& writer,
+    Wt::Dbo::SqlConnectionPool& connection_pool,
+    std::vector<std::string> tokens)
+    : writer_(writer)
+    , connection_pool_(connection_pool)
+    , tokens_(std::move(tokens))
+{
+}
+
+climate_resource::~climate_resource()
+{
+    beingDeleted();
+}
+
+void climate_resource::handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+    if (request.method() != "POST" && request.method() != "GET")
+    {
+        response.addHeader("Allow", "GET, POST");
+        reply(response, 405, "use GET or POST");
+        return;
+    }
+    if (!has_bearer_token(request, tokens_))
+    {
+        response.addHeader("WWW-Authenticate", "Bearer");
+        reply(response, 401, "missing or unknown token");
+        return;
+    }
+
+    if (request.method() == "GET")
+    {
+        read_rollups(request, response);
+    }
+    else
+    {
+        append_points(request, response);
+    }
+}
+
+void climate_resource::append_points(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+    std::istream& in = request.in();
+    std::string line;
+    if (!std::getline(in, line) || line.substr(0, line.find_last_not_of("\r") + 1) != expected_header)
+    {
+        reply(response, 400, std::string("line 1: expected the header ") + expected_header);
+        return;
+    }
+
+    const long long latest_time = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() + max_clock_skew;
+    std::vector<models::climate_point> points;
+    std::ostringstream errors;
+    std::size_t error_count = 0;
+    for (std::size_t number = 2; std::getline(in, line); ++number)
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+        if (points.size() == max_points)
+        {
+            reply(response, 413, "more than " + std::to_string(max_points) + " points");
+            return;
+        }
+
+        std::istringstream fields(line);
+        std::string hothouse_id, metric, measured_at, value;
+        std::getline(fields, hothouse_id, ',');
+        std::getline(fields, metric, ',');
+        std::getline(fields, measured_at, ',');
+        std::getline(fields, value);
+
+        models::climate_point point;
+        long long time = 0;
+        if (!parse_integer(hothouse_id, point.hothouse_id) || point.hothouse_id <= 0 ||
+            !parse_metric(metric, point.metric) ||
+            !parse_integer(measured_at, time) || time < earliest_time || time > latest_time ||
+            !parse_value(value, point.value))
+        {
+            if (++error_count <= max_reported_errors)
+            {
+                errors << "line " << number << ": invalid point '" << line << "'\n";
+            }
+            continue;
+        }
+        point.measured_at = time;
+        points.push_back(point);
+    }
+
+    if (error_count > 0)
+    {
+        errors << error_count << " invalid lines";
+        reply(response, 400, errors.str());
+        return;
+    }
+
+    const std::size_t accepted = points.size();
+    if (!writer_.append(std::move(points)))
+    {
+        response.addHeader("Retry-After", "10");
+        reply(response, 503, "climate writer is behind, retry later");
+        return;
+    }
+    reply(response, 202, std::to_string(accepted) + " points accepted");
+}
+
+void climate_resource::read_rollups(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+    const std::string* hothouse_id = request.getParameter("hothouse_id");
+    const std::string* metric = request.getParameter("metric");
+    const std::string* resolution = request.getParameter("resolution");
+    const std::string* from = request.getParameter("from");
+    const std::string* to = request.getParameter("to");
+
+    long long id = 0;
+    climate_metric parsed_metric = climate_metric::temperature;
+    climate_resolution parsed_resolution = climate_resolution::hourly;
+    long long first = 0;
+    long long last = 0;
+    if (!hothouse_id || !parse_integer(*hothouse_id, id) ||
+        !metric || !parse_metric(*metric, parsed_metric) ||
+        !resolution || !parse_resolution(*resolution, parsed_resolution) ||
+        !from || !parse_integer(*from, first) ||
+        !to || !parse_integer(*to, last) || first >= last)
+    {
+        reply(response, 400, "expected hothouse_id, metric, resolution, from and to, from before to");
+        return;
+    }
+    if ((last - first) / static_cast<long long>(parsed_resolution) > max_buckets)
+    {
+        reply(response, 400, "more than " + std::to_string(max_buckets) + " buckets, use a coarser resolution");
+        return;
+    }
+
+    std::vector<models::climate_rollup> rollups;
+    try
+    {
+        const connection_pool::admission admission(connection_pool::priority::read);
+        models::session session(connection_pool_);
+        Wt::Dbo::Transaction transaction(session);
+        rollups = session.climate_rollups(id, parsed_metric, parsed_resolution, first, last);
+    }
+    catch (const connection_pool::overloaded&)
+    {
+        response.addHeader("Retry-After", "1");
+        reply(response, 503, "database is busy, retry later");
+        return;
+    }
+
+    response.setMimeType("text/csv; charset=utf-8");
+    std::ostream& out = response.out();
+    out.precision(std::numeric_limits<double>::digits10);
+    out << "bucket_start,min,max,mean,count\r\n";
+    for (const models::climate_rollup& rollup : rollups)
+    {
+        out << rollup.bucket_start << ',' << rollup.min << ',' << rollup.max << ','
+            << rollup.mean << ',' << rollup.count << "\r\n";
+    }
+}
+
+} // agromaster
\ No newline at end of file
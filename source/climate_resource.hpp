@@ -0,0 +1,52 @@
+#pragma once
+#ifndef AGROMASTER_CLIMATE_RESOURCE_HPP_
+#define AGROMASTER_CLIMATE_RESOURCE_HPP_
+
+#include <string>
+#include <vector>
+
+#include <Wt/Dbo/SqlConnectionPool.h>
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+#include <Wt/WResource.h>
+
+#include "climate_writer.hpp"
+
+namespace agromaster
+{
+
+// Endpoint for the climate sensors.
+//
+// A POST carries text/csv with the header line "hothouse_id,metric,measured_at,value",
+// where metric is temperature, humidity, co2 or soil_moisture and measured_at is in
+// seconds since the epoch. Callers authenticate like the ingest endpoint. The body is
+// validated line by line while it is read; a valid batch is handed to the climate_writer
+// and answered with 202, an invalid one is rejected as a whole with 400, and 503 tells the
+// sensor to retry while the writer is behind.
+//
+// A GET with hothouse_id, metric, resolution (hourly or daily), from and to returns the
+// rollups of the buckets starting in [from, to) as text/csv with the header line
+// "bucket_start,min,max,mean,count". It reads the rollups only, never the raw points.
+class climate_resource final : public Wt::WResource
+{
+public:
+    // Ranges asking for more buckets than this are refused with 400.
+    static constexpr long long max_buckets = 10000;
+
+    climate_resource(climate_writer& writer, Wt::Dbo::SqlConnectionPool& connection_pool, std::vector<std::string> tokens);
+    ~climate_resource() override;
+
+    void handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+
+private:
+    void append_points(const Wt::Http::Request& request, Wt::Http::Response& response);
+    void read_rollups(const Wt::Http::Request& request, Wt::Http::Response& response);
+
+    climate_writer& writer_;
+    Wt::Dbo::SqlConnectionPool& connection_pool_;
+    const std::vector<std::string> tokens_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_CLIMATE_RESOURCE_HPP_
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include "climate_writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#include <Wt/Dbo/Exception.h>
+#include <Wt/Dbo/Transaction.h>
+#include <Wt/WDateTime.h>
+#include <Wt/WLogger.h>
+
+#include "configuration.hpp"
+#include "metrics.hpp"
+
+namespace
+{
+
+// Spans whose rollups are refreshed by one statement, three bind parameters each.
+constexpr std::size_t rollup_chunk = 300;
+
+std::int64_t month_start(std::int64_t time)
+{
+    const Wt::WDate date = Wt::WDateTime::fromTime_t(static_cast<std::time_t>(time)).date();
+    return Wt::WDateTime(Wt::WDate(date.year(), date.month(), 1)).toTime_t();
+}
+
+std::int64_t next_month_start(std::int64_t start)
+{
+    const Wt::WDate date = Wt::WDateTime::fromTime_t(static_cast<std::time_t>(start)).date();
+    return Wt::WDateTime(date.addMonths(1)).toTime_t();
+}
+
+// The hours each hothouse got points in, consecutive hours joined into one span. A
+// backfilled point only adds its own hour instead of stretching one range over the flush.
+std::vector<agromaster::models::climate_span> touched_hours(const std::vector<agromaster::models::climate_point>& points)
+{
+    const std::int64_t hour = static_cast<std::int64_t>(agromaster::models::climate_resolution::hourly);
+    std::map<long long, std::set<std::int64_t>> hours;
+    for (const agromaster::models::climate_point& point : points)
+    {
+        hours[point.hothouse_id].insert(point.measured_at - point.measured_at % hour);
+    }
+
+    std::vector<agromaster::models::climate_span> spans;
+    for (const auto& hothouse_hours : hours)
+    {
+        for (std::int64_t start : hothouse_hours.second)
+        {
+            if (!spans.empty() && spans.back().hothouse_id == hothouse_hours.first && spans.back().to == start)
+            {
+                spans.back().to += hour;
+                continue;
+            }
+            agromaster::models::climate_span span;
+            span.hothouse_id = hothouse_hours.first;
+            span.from = start;
+            span.to = start + hour;
+            spans.push_back(span);
+        }
+    }
+    return spans;
+}
+
+std::string partition_name(std::int64_t start)
+{
+    const Wt::WDate date = Wt::WDateTime::fromTime_t(static_cast<std::time_t>(start)).date();
+    char name[32];
+    std::snprintf(name, sizeof(name), "climate_reading_y%04dm%02d", date.year(), date.month());
+    return name;
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+climate_writer::settings climate_writer::settings::load(const Wt::WServer& server)
+{
+    using namespace configuration;
+
+    settings config;
+    read_number(server, "AGROMASTER_CLIMATE_FLUSH_POINTS", "agromaster-climate-flush-points", config.flush_points);
+    read_duration(server, "AGROMASTER_CLIMATE_FLUSH_INTERVAL", "agromaster-climate-flush-interval", config.flush_interval);
+    read_number(server, "AGROMASTER_CLIMATE_MAX_BUFFERED_POINTS", "agromaster-climate-max-buffered-points",
+        config.max_buffered_points);
+    config.flush_points = std::max<std::size_t>(config.flush_points, 1);
+    config.max_buffered_points = std::max(config.max_buffered_points, config.flush_points);
+    return config;
+}
+
+climate_writer::climate_writer(Wt::Dbo::SqlConnectionPool& connection_pool, const settings& config)
+    : session_(connection_pool)
+    , settings_(config)
+{
+    try
+    {
+        Wt::Dbo::Transaction transaction(session_);
+        partitioned_ = session_.climate_readings_partitioned();
+    }
+    catch (const Wt::Dbo::Exception&)
+    {
+        // Not Postgres.
+        partitioned_ = false;
+    }
+    thread_ = std::thread(&climate_writer::run, this);
+}
+
+climate_writer::~climate_writer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+bool climate_writer::append(std::vector<models::climate_point> points)
+{
+    bool full = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || buffer_.size() + points.size() > settings_.max_buffered_points)
+        {
+            stats_.refused += points.size();
+            return false;
+        }
+        stats_.appended += points.size();
+        buffer_.insert(buffer_.end(), std::make_move_iterator(points.begin()), std::make_move_iterator(points.end()));
+        full = buffer_.size() >= settings_.flush_points;
+    }
+    if (full)
+    {
+        wake_.notify_one();
+    }
+    return true;
+}
+
+climate_writer::statistics climate_writer::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics snapshot = stats_;
+    snapshot.buffered = buffer_.size();
+    return snapshot;
+}
+
+void climate_writer::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool failed = false;
+    for (;;)
+    {
+        // After a failed flush the buffer may still be full enough to flush at once; wait the
+        // whole interval instead of hammering a database that is down.
+        wake_.wait_for(lock, settings_.flush_interval,
+            [this, failed] { return stopping_ || (!failed && buffer_.size() >= settings_.flush_points); });
+        if (buffer_.empty())
+        {
+            if (stopping_)
+            {
+                return;
+            }
+            continue;
+        }
+
+        std::vector<models::climate_point> points;
+        points.swap(buffer_);
+        lock.unlock();
+        const bool written = write(points);
+        lock.lock();
+
+        ++stats_.flushes;
+        failed = !written;
+        if (written)
+        {
+            stats_.written += points.size();
+        }
+        else
+        {
+            ++stats_.failed_flushes;
+            // Retried with the next flush while there is room; a failure at shutdown is final.
+            if (!stopping_ && buffer_.size() + points.size() <= settings_.max_buffered_points)
+            {
+                buffer_.insert(buffer_.begin(), points.begin(), points.end());
+            }
+            else
+            {
+                stats_.discarded += points.size();
+            }
+            if (stopping_)
+            {
+                return;
+            }
+        }
+    }
+}
+
+bool climate_writer::write(const std::vector<models::climate_point>& points)
+{
+    const metrics::handler_scope scope("write_climate");
+    std::set<long long> hothouse_ids;
+    for (const models::climate_point& point : points)
+    {
+        hothouse_ids.insert(point.hothouse_id);
+    }
+
+    try
+    {
+        Wt::Dbo::Transaction transaction(session_);
+        // A hothouse deleted while its points waited would fail the whole transaction.
+        const std::set<long long> existing = session_.existing_hothouses(hothouse_ids);
+        std::vector<models::climate_point> known;
+        known.reserve(points.size());
+        std::copy_if(points.begin(), points.end(), std::back_inserter(known),
+            [&existing](const models::climate_point& point) { return existing.count(point.hothouse_id) > 0; });
+        if (known.size() < points.size())
+        {
+            Wt::log("warning") << "climate_writer: skipped " << points.size() - known.size()
+                << " points of unknown hothouses";
+        }
+
+        create_partitions(known);
+        session_.append_climate_points(known);
+
+        const std::vector<models::climate_span> spans = touched_hours(known);
+        for (std::size_t first = 0; first < spans.size(); first += rollup_chunk)
+        {
+            const auto last = spans.begin() + std::min(spans.size(), first + rollup_chunk);
+            session_.refresh_climate_rollups(std::vector<models::climate_span>(spans.begin() + first, last));
+        }
+        transaction.commit();
+        return true;
+    }
+    catch (const std::exception& error)
+    {
+        Wt::log("error") << "climate_writer: writing " << points.size() << " points failed: " << error.what();
+        // Partitions created by the failed transaction were rolled back with it.
+        partitions_.clear();
+        return false;
+    }
+}
+
+void climate_writer::create_partitions(const std::vector<models::climate_point>& points)
+{
+    if (!partitioned_)
+    {
+        return;
+    }
+
+    std::set<std::int64_t> months;
+    for (const models::climate_point& point : points)
+    {
+        months.insert(month_start(point.measured_at));
+    }
+    for (std::int64_t start : months)
+    {
+        if (partitions_.count(start))
+        {
+            continue;
+        }
+        session_.create_climate_partition(partition_name(start), start, next_month_start(start));
+        partitions_.insert(start);
+    }
+}
+
+} // agromaster
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef AGROMASTER_CLIMATE_WRITER_HPP_
+#define AGROMASTER_CLIMATE_WRITER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <Wt/Dbo/SqlConnectionPool.h>
+#include <Wt/WServer.h>
+
+#include "models.hpp"
+
+namespace agromaster
+{
+
+// Buffers climate sensor points and appends them to the database from a thread of its own.
+//
+// The buffer is written whenever flush_points points are waiting or flush_interval has
+// passed, in one transaction that inserts the points, refreshes the hourly and daily
+// rollups they touch and, on Postgres, creates missing monthly partitions. The writer
+// never holds more than one connection, so give it a pool of its own to keep a burst of
+// sensors off the connections of the UI. At most max_buffered_points points wait; append()
+// refuses more until the database catches up.
+class climate_writer
+{
+public:
+    struct settings
+    {
+        std::size_t flush_points = 5000;
+        std::chrono::milliseconds flush_interval{ 5000 };
+        std::size_t max_buffered_points = 500000;
+
+        static settings load(const Wt::WServer& server);
+    };
+
+    struct statistics
+    {
+        std::uint64_t appended = 0;
+        std::uint64_t written = 0;
+        std::uint64_t refused = 0;
+        std::uint64_t discarded = 0;
+        std::uint64_t flushes = 0;
+        std::uint64_t failed_flushes = 0;
+        std::size_t buffered = 0;
+    };
+
+    climate_writer(Wt::Dbo::SqlConnectionPool& connection_pool, const settings& config);
+    // Writes what is still buffered before the thread stops.
+    ~climate_writer();
+
+    climate_writer(const climate_writer&) = delete;
+    climate_writer& operator=(const climate_writer&) = delete;
+
+    // Returns false, and keeps none of the points, when they do not fit in the buffer.
+    bool append(std::vector<models::climate_point> points);
+
+    statistics stats() const;
+
+private:
+    void run();
+    // Returns false when the transaction failed.
+    bool write(const std::vector<models::climate_point>& points);
+    void create_partitions(const std::vector<models::climate_point>& points);
+
+    // Only used by the writer thread once it runs.
+    models::session session_;
+    const settings settings_;
+    bool partitioned_ = false;
+    // First second of each month whose partition is known to exist.
+    std::set<std::int64_t> partitions_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<models::climate_point> buffer_;
+    bool stopping_ = false;
+    statistics stats_;
+    std::thread thread_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_CLIMATE_WRITER_HPP_
\ No newline at end of file
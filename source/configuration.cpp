@@ -0,0 +1,21 @@
+#include "configuration.hpp"
+
+#include <cstdlib>
+
+namespace agromaster
+{
+namespace configuration
+{
+
+bool read_setting(const Wt::WServer& server, const char* variable, const char* property, std::string& value)
+{
+    if (const char* environment_value = std::getenv(variable))
+    {
+        value = environment_value;
+        return true;
+    }
+    return server.readConfigurationProperty(property, value);
+}
+
+} // configuration
+} // agromaster
\ No newline at end of file
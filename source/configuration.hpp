@@ -0,0 +1,55 @@
+#pragma once
+#ifndef AGROMASTER_CONFIGURATION_HPP_
+#define AGROMASTER_CONFIGURATION_HPP_
+
+#include <chrono>
+#include <exception>
+#include <string>
+
+#include <Wt/WLogger.h>
+#include <Wt/WServer.h>
+
+namespace agromaster
+{
+namespace configuration
+{
+
+// Every setting has an AGROMASTER_* environment variable and an agromaster-* property of
+// the Wt configuration file; the environment variable takes precedence.
+bool read_setting(const Wt::WServer& server, const char* variable, const char* property, std::string& value);
+
+// Leaves number unchanged when the setting is absent or not a number.
+template <typename Number>
+void read_number(const Wt::WServer& server, const char* variable, const char* property, Number& number)
+{
+    std::string value;
+    if (!read_setting(server, variable, property, value))
+    {
+        return;
+    }
+    try
+    {
+        number = static_cast<Number>(std::stol(value));
+    }
+    catch (const std::exception&)
+    {
+        Wt::log("warning") << "configuration: ignoring " << property << " = '" << value << "'";
+    }
+}
+
+template <typename Rep, typename Period>
+void read_duration(
+    const Wt::WServer& server,
+    const char* variable,
+    const char* property,
+    std::chrono::duration<Rep, Period>& duration)
+{
+    Rep count = duration.count();
+    read_number(server, variable, property, count);
+    duration = std::chrono::duration<Rep, Period>(count);
+}
+
+} // configuration
+} // agromaster
+
+#endif // AGROMASTER_CONFIGURATION_HPP_
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "connection_pool.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+#include <Wt/Dbo/Exception.h>
+#include <Wt/WLogger.h>
+
+#include "configuration.hpp"
+#include "metrics.hpp"
+
+namespace
+{
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+thread_local const agromaster::connection_pool::admission* current_admission = nullptr;
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+connection_pool::settings connection_pool::settings::load(const Wt::WServer& server)
+{
+    using namespace configuration;
+
+    settings config;
+    config.max_connections = std::max(config.max_connections, 2 * static_cast<int>(std::thread::hardware_concurrency()));
+
+    read_setting(server, "AGROMASTER_DB", "agromaster-db", config.connection_string);
+    read_number(server, "AGROMASTER_DB_MIN_CONNECTIONS", "agromaster-db-min-connections", config.min_connections);
+    read_number(server, "AGROMASTER_DB_MAX_CONNECTIONS", "agromaster-db-max-connections", config.max_connections);
+    read_duration(server, "AGROMASTER_DB_IDLE_TIMEOUT", "agromaster-db-idle-timeout", config.idle_timeout);
+    read_duration(server, "AGROMASTER_DB_VALIDATE_AFTER", "agromaster-db-validate-after", config.validate_after);
+    read_duration(server, "AGROMASTER_DB_EDIT_TIMEOUT", "agromaster-db-edit-timeout", config.edit_timeout);
+    read_duration(server, "AGROMASTER_DB_READ_TIMEOUT", "agromaster-db-read-timeout", config.read_timeout);
+    read_duration(server, "AGROMASTER_DB_CHECKOUT_TIMEOUT", "agromaster-db-checkout-timeout", config.checkout_timeout);
+    read_number(server, "AGROMASTER_DB_MAX_WAITERS", "agromaster-db-max-waiters", config.max_waiters);
+    read_duration(server, "AGROMASTER_DB_SLOW_WAIT", "agromaster-db-slow-wait", config.slow_wait);
+
+    config.max_connections = std::max(config.max_connections, 1);
+    config.min_connections = std::min(std::max(config.min_connections, 0), config.max_connections);
+    config.max_waiters = std::max(config.max_waiters, 0);
+    return config;
+}
+
+connection_pool::admission::admission(priority level)
+    : level_(level)
+    , outer_(current_admission)
+    , started_(outer_ ? outer_->started_ : std::chrono::steady_clock::now())
+{
+    current_admission = this;
+}
+
+connection_pool::admission::~admission()
+{
+    current_admission = outer_;
+}
+
+const connection_pool::admission* connection_pool::admission::current()
+{
+    return current_admission;
+}
+
+connection_pool::connection_pool(connector connect, const settings& config)
+    : settings_(config)
+    , connect_(std::move(connect))
+{
+    stats_.max_connections = settings_.max_connections;
+    const clock::time_point now = clock::now();
+    for (int i = 0; i < settings_.min_connections; ++i)
+    {
+        std::unique_ptr<Wt::Dbo::SqlConnection> connection = open_connection();
+        if (!validate(*connection))
+        {
+            throw Wt::Dbo::Exception("connection_pool: a new connection failed validation");
+        }
+        idle_.push_back(idle_connection{ std::move(connection), now });
+        ++open_;
+    }
+}
+
+connection_pool::~connection_pool() = default;
+
+std::unique_ptr<Wt::Dbo::SqlConnection> connection_pool::getConnection()
+{
+    const clock::time_point requested = clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Callers already waiting go first, unless this one has a higher priority.
+    if (!has_capacity() || !waiters_.empty())
+    {
+        const priority level = admission::current() ? admission::current()->level() : priority::read;
+        const waiter self{ level, next_waiter_++ };
+        if (static_cast<int>(waiters_.size()) >= settings_.max_waiters)
+        {
+            // Bulk work and reads queued first must not lock edits out.
+            if (waiters_.empty() || !(level < waiters_.rbegin()->first))
+            {
+                ++stats_.rejected;
+                throw overloaded("connection_pool: too many callers waiting for a database connection");
+            }
+            evicted_.insert(*waiters_.rbegin());
+            waiters_.erase(std::prev(waiters_.end()));
+            available_.notify_all();
+        }
+
+        waiters_.insert(self);
+        ++stats_.waits;
+        const bool admitted = available_.wait_until(lock, deadline(requested),
+            [this, &self] { return evicted_.count(self) > 0 || (*waiters_.begin() == self && has_capacity()); });
+        const bool evicted = evicted_.erase(self) > 0;
+        waiters_.erase(self);
+        // The next waiter may be first in line now.
+        available_.notify_all();
+        if (evicted)
+        {
+            ++stats_.rejected;
+            throw overloaded("connection_pool: turned away for a caller of higher priority");
+        }
+        if (!admitted)
+        {
+            ++stats_.timeouts;
+            throw overloaded("connection_pool: timed out waiting for a database connection");
+        }
+    }
+
+    std::unique_ptr<Wt::Dbo::SqlConnection> connection;
+    clock::time_point idle_since;
+    if (!idle_.empty())
+    {
+        // Most recently returned first, so the surplus connections age out.
+        connection = std::move(idle_.back().connection);
+        idle_since = idle_.back().since;
+        idle_.pop_back();
+    }
+    else
+    {
+        ++open_;
+    }
+    lock.unlock();
+
+    try
+    {
+        if (connection && clock::now() - idle_since > settings_.validate_after && !validate(*connection))
+        {
+            connection.reset();
+            std::lock_guard<std::mutex> discarded_lock(mutex_);
+            ++stats_.discarded;
+        }
+        if (!connection)
+        {
+            connection = open_connection();
+        }
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> failed_lock(mutex_);
+        --open_;
+        available_.notify_all();
+        throw;
+    }
+
+    const clock::time_point checked_out = clock::now();
+    const microseconds wait = duration_cast<microseconds>(checked_out - requested);
+
+    lock.lock();
+    checked_out_[connection.get()] = checked_out;
+    ++stats_.checkouts;
+    stats_.total_wait += wait;
+    stats_.max_wait = std::max(stats_.max_wait, wait);
+    stats_.peak_in_use = std::max(stats_.peak_in_use, static_cast<int>(checked_out_.size()));
+    lock.unlock();
+
+    if (wait > settings_.slow_wait)
+    {
+        Wt::log("warning")
+            << "connection_pool: waited " << wait.count() / 1000 << " ms for a connection ("
+            << settings_.max_connections << " connections in use)";
+    }
+    return connection;
+}
+
+void connection_pool::returnConnection(std::unique_ptr<Wt::Dbo::SqlConnection> connection)
+{
+    const clock::time_point now = clock::now();
+    std::vector<std::unique_ptr<Wt::Dbo::SqlConnection>> surplus;
+    clock::duration checkout_duration = clock::duration::zero();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto checkout = checked_out_.find(connection.get());
+        if (checkout != checked_out_.end())
+        {
+            checkout_duration = now - checkout->second;
+            const microseconds duration = duration_cast<microseconds>(checkout_duration);
+            stats_.total_checkout += duration;
+            stats_.max_checkout = std::max(stats_.max_checkout, duration);
+            checked_out_.erase(checkout);
+        }
+        idle_.push_back(idle_connection{ std::move(connection), now });
+        surplus = shrink(now);
+    }
+    available_.notify_all();
+    // Wt::Dbo holds a connection exactly for the length of a transaction.
+    metrics::instance().observe_transaction(checkout_duration);
+}
+
+void connection_pool::prepareForDropTables() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const idle_connection& idle : idle_)
+    {
+        idle.connection->prepareForDropTables();
+    }
+}
+
+connection_pool::statistics connection_pool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics snapshot = stats_;
+    snapshot.open_connections = open_;
+    snapshot.idle_connections = static_cast<int>(idle_.size());
+    snapshot.waiting = static_cast<int>(waiters_.size());
+    return snapshot;
+}
+
+bool connection_pool::has_capacity() const
+{
+    return !idle_.empty() || open_ < settings_.max_connections;
+}
+
+connection_pool::clock::time_point connection_pool::deadline(clock::time_point requested) const
+{
+    const admission* operation = admission::current();
+    if (!operation)
+    {
+        return requested + settings_.checkout_timeout;
+    }
+
+    switch (operation->level())
+    {
+    case priority::edit:
+        return operation->started() + settings_.edit_timeout;
+    case priority::read:
+        return operation->started() + settings_.read_timeout;
+    case priority::bulk:
+        break;
+    }
+    return operation->started() + settings_.checkout_timeout;
+}
+
+std::unique_ptr<Wt::Dbo::SqlConnection> connection_pool::open_connection()
+{
+    return connect_();
+}
+
+bool connection_pool::validate(Wt::Dbo::SqlConnection& connection)
+{
+    try
+    {
+        connection.executeSql("select 1");
+        return true;
+    }
+    catch (const std::exception& error)
+    {
+        Wt::log("warning") << "connection_pool: dropping a broken connection: " << error.what();
+        return false;
+    }
+}
+
+std::vector<std::unique_ptr<Wt::Dbo::SqlConnection>> connection_pool::shrink(clock::time_point now)
+{
+    std::vector<std::unique_ptr<Wt::Dbo::SqlConnection>> surplus;
+    // idle_ is ordered by return time, so the longest idle connections are at the front.
+    auto expired = idle_.begin();
+    while (expired != idle_.end() &&
+        open_ - static_cast<int>(surplus.size()) > settings_.min_connections &&
+        now - expired->since > settings_.idle_timeout)
+    {
+        surplus.push_back(std::move(expired->connection));
+        ++expired;
+    }
+    idle_.erase(idle_.begin(), expired);
+    open_ -= static_cast<int>(surplus.size());
+    return surplus;
+}
+
+} // agromaster
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+#ifndef AGROMASTER_CONNECTION_POOL_HPP_
+#define AGROMASTER_CONNECTION_POOL_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Wt/Dbo/Exception.h>
+#include <Wt/Dbo/SqlConnection.h>
+#include <Wt/Dbo/SqlConnectionPool.h>
+#include <Wt/WServer.h>
+
+namespace agromaster
+{
+
+// Database connection pool that grows on demand up to max_connections and closes
+// connections idle for longer than idle_timeout down to min_connections.
+//
+// The min_connections connections are opened and checked with a trivial query when the
+// pool is created, so a wrong connection string fails at startup instead of at the first
+// login. Connections that were idle for longer than validate_after are checked again
+// before they are handed out. Every checkout is timed; stats() reports wait and
+// checkout durations and how often callers found the pool saturated.
+//
+// When the pool is saturated, callers queue by the priority of their admission, edits
+// before reads before bulk work, and in arrival order within a priority. The queue holds
+// at most max_waiters callers; when it is full, a newcomer that outranks the last waiter
+// takes its place and the last waiter is turned away, otherwise the newcomer is. Every
+// caller also gives up at the deadline of its operation. Callers turned away or out of
+// time throw overloaded, so an overloaded server fails fast instead of stacking up
+// blocked threads.
+class connection_pool final : public Wt::Dbo::SqlConnectionPool
+{
+public:
+    enum class priority
+    {
+        edit,
+        read,
+        bulk,
+    };
+
+    // Priority and deadline of the checkouts made by this thread while the admission
+    // lives. The deadline runs from the start of the outermost admission, so all the
+    // transactions of one operation share one budget; a nested admission only changes the
+    // priority. Checkouts outside any admission are reads bounded by checkout_timeout.
+    class admission
+    {
+    public:
+        explicit admission(priority level);
+        ~admission();
+
+        admission(const admission&) = delete;
+        admission& operator=(const admission&) = delete;
+
+        // Innermost admission of this thread, nullptr outside any admission.
+        static const admission* current();
+
+        priority level() const { return level_; }
+        std::chrono::steady_clock::time_point started() const { return started_; }
+
+    private:
+        const priority level_;
+        const admission* outer_;
+        const std::chrono::steady_clock::time_point started_;
+    };
+
+    // No connection could be handed out in time.
+    class overloaded : public Wt::Dbo::Exception
+    {
+    public:
+        using Wt::Dbo::Exception::Exception;
+    };
+
+    struct settings
+    {
+        std::string connection_string = "host=localhost password=example dbname=agronomy user=postgres";
+        int min_connections = 2;
+        int max_connections = 10;
+        std::chrono::seconds idle_timeout{ 60 };
+        std::chrono::seconds validate_after{ 30 };
+        // Deadlines of operations by priority; bulk work and checkouts outside any
+        // admission use checkout_timeout.
+        std::chrono::milliseconds edit_timeout{ 5000 };
+        std::chrono::milliseconds read_timeout{ 2000 };
+        std::chrono::milliseconds checkout_timeout{ 30000 };
+        // Callers allowed to wait for a connection at once.
+        int max_waiters = 64;
+        // Waits longer than this are logged as warnings.
+        std::chrono::milliseconds slow_wait{ 100 };
+
+        static settings load(const Wt::WServer& server);
+    };
+
+    struct statistics
+    {
+        int open_connections = 0;
+        int idle_connections = 0;
+        int max_connections = 0;
+        int peak_in_use = 0;
+        std::uint64_t checkouts = 0;
+        std::uint64_t waits = 0;
+        std::uint64_t timeouts = 0;
+        // Callers turned away because max_waiters callers were waiting already, either on
+        // arrival or later for a caller of higher priority.
+        std::uint64_t rejected = 0;
+        int waiting = 0;
+        std::uint64_t discarded = 0;
+        std::chrono::microseconds total_wait{ 0 };
+        std::chrono::microseconds max_wait{ 0 };
+        std::chrono::microseconds total_checkout{ 0 };
+        std::chrono::microseconds max_checkout{ 0 };
+    };
+
+    using connector = std::function<std::unique_ptr<Wt::Dbo::SqlConnection>()>;
+
+    // connect opens one new connection; it may be called from any thread.
+    connection_pool(connector connect, const settings& config);
+    ~connection_pool() override;
+
+    std::unique_ptr<Wt::Dbo::SqlConnection> getConnection() override;
+    void returnConnection(std::unique_ptr<Wt::Dbo::SqlConnection> connection) override;
+    void prepareForDropTables() const override;
+
+    statistics stats() const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct idle_connection
+    {
+        std::unique_ptr<Wt::Dbo::SqlConnection> connection;
+        clock::time_point since;
+    };
+
+    // Priority, then arrival order.
+    using waiter = std::pair<priority, std::uint64_t>;
+
+    // Called with mutex_ held.
+    bool has_capacity() const;
+    clock::time_point deadline(clock::time_point requested) const;
+    std::unique_ptr<Wt::Dbo::SqlConnection> open_connection();
+    static bool validate(Wt::Dbo::SqlConnection& connection);
+    // Takes the surplus connections idle past idle_timeout out of the pool. Called with
+    // mutex_ held; the caller closes them after releasing it.
+    std::vector<std::unique_ptr<Wt::Dbo::SqlConnection>> shrink(clock::time_point now);
+
+    const settings settings_;
+    const connector connect_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::set<waiter> waiters_;
+    // Waiters turned away for a caller of higher priority that have not woken up yet.
+    std::set<waiter> evicted_;
+    std::uint64_t next_waiter_ = 0;
+    std::vector<idle_connection> idle_;
+    std::map<const Wt::Dbo::SqlConnection*, clock::time_point> checked_out_;
+    int open_ = 0;
+    statistics stats_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_CONNECTION_POOL_HPP_
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "crops_model.hpp"
+
+#include <string>
+#include <utility>
+
+namespace agromaster
+{
+
+crops_model::crops_model(catalog_cache::crops_type crops, bool editable)
+    : crops_(std::move(crops))
+    , editable_(editable)
+{
+}
+
+int crops_model::columnCount(const Wt::WModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return editable_ ? delete_column + 1 : schedules_column + 1;
+}
+
+int crops_model::rowCount(const Wt::WModelIndex& parent) const
+{
+    if (parent.isValid() || !crops_)
+    {
+        return 0;
+    }
+    return static_cast<int>(crops_->size());
+}
+
+Wt::cpp17::any crops_model::data(const Wt::WModelIndex& index, Wt::ItemDataRole role) const
+{
+    if (role == Wt::ItemDataRole::StyleClass)
+    {
+        return Wt::WString(index.column() < schedules_column ? "text-center" : "btn btn-secondary btn-sm");
+    }
+    if ((role != Wt::ItemDataRole::Display && role != Wt::ItemDataRole::User) || index.row() >= rowCount())
+    {
+        return Wt::cpp17::any();
+    }
+
+    const models::crop_summary& crop = (*crops_)[index.row()];
+    if (role == Wt::ItemDataRole::User)
+    {
+        return crop.id;
+    }
+    switch (index.column())
+    {
+    case title_column:
+        return Wt::WString(crop.title);
+    case hothouses_column:
+        return Wt::WString(std::to_string(crop.hothouses_count));
+    case yields_column:
+        return Wt::WString(std::to_string(crop.yields));
+    case spent_fertilizers_column:
+        return Wt::WString(std::to_string(crop.spent_fertilizers));
+    case schedules_column:
+        return Wt::WString(u8"");
+    case change_column:
+        return Wt::WString(u8"");
+    case delete_column:
+        return Wt::WString(u8"");
+    default:
+        return Wt::cpp17::any();
+    }
+}
+
+Wt::cpp17::any crops_model::headerData(int section, Wt::Orientation orientation, Wt::ItemDataRole role) const
+{
+    if (orientation != Wt::Orientation::Horizontal || role != Wt::ItemDataRole::Display)
+    {
+        return Wt::cpp17::any();
+    }
+
+    switch (section)
+    {
+    case title_column:
+        return Wt::WString(u8"");
+    case hothouses_column:
+        return Wt::WString(u8" ");
+    case yields_column:
+        return Wt::WString(u8", ");
+    case spent_fertilizers_column:
+        return Wt::WString(u8" , ");
+    default:
+        return Wt::WString();
+    }
+}
+
+models::crop_summary crops_model::crop(int row) const
+{
+    return row >= 0 && row < rowCount() ? (*crops_)[row] : models::crop_summary();
+}
+
+void crops_model::set_crops(catalog_cache::crops_type crops)
+{
+    crops_ = std::move(crops);
+    reset();
+}
+
+} // agromaster
\ No newline at end of file
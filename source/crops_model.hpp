@@ -0,0 +1,51 @@
+#pragma once
+#ifndef AGROMASTER_CROPS_MODEL_HPP_
+#define AGROMASTER_CROPS_MODEL_HPP_
+
+#include <Wt/WAbstractTableModel.h>
+
+#include "catalog_cache.hpp"
+#include "models.hpp"
+
+namespace agromaster
+{
+
+// Read-only table model over a snapshot of the crops from catalog_cache. The snapshot is
+// shared by every session that shows the same version of the catalog, so a session pays
+// only for the cells its table view renders, not for a copy of the rows.
+class crops_model final : public Wt::WAbstractTableModel
+{
+public:
+    enum column
+    {
+        title_column = 0,
+        hothouses_column,
+        yields_column,
+        spent_fertilizers_column,
+        schedules_column,
+        change_column,
+        delete_column
+    };
+
+    crops_model(catalog_cache::crops_type crops, bool editable);
+
+    int columnCount(const Wt::WModelIndex& parent = Wt::WModelIndex()) const override;
+    int rowCount(const Wt::WModelIndex& parent = Wt::WModelIndex()) const override;
+    Wt::cpp17::any data(const Wt::WModelIndex& index, Wt::ItemDataRole role = Wt::ItemDataRole::Display) const override;
+    Wt::cpp17::any headerData(
+        int section,
+        Wt::Orientation orientation = Wt::Orientation::Horizontal,
+        Wt::ItemDataRole role = Wt::ItemDataRole::Display) const override;
+
+    models::crop_summary crop(int row) const;
+    // Switches to a newer snapshot; the view redraws only its visible rows.
+    void set_crops(catalog_cache::crops_type crops);
+
+private:
+    catalog_cache::crops_type crops_;
+    bool editable_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_CROPS_MODEL_HPP_
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "csv.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace agromaster
+{
+
+std::string csv_trimmed(const std::string& text)
+{
+    const auto first = std::find_if_not(text.begin(), text.end(), [](unsigned char c) { return std::isspace(c); });
+    const auto last = std::find_if_not(text.rbegin(), text.rend(), [](unsigned char c) { return std::isspace(c); });
+    return first < last.base() ? std::string(first, last.base()) : std::string();
+}
+
+std::vector<std::string> split_csv_line(const std::string& line)
+{
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); ++i)
+    {
+        const char c = line[i];
+        if (quoted)
+        {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+            {
+                fields.back() += '"';
+                ++i;
+            }
+            else if (c == '"')
+            {
+                quoted = false;
+            }
+            else
+            {
+                fields.back() += c;
+            }
+        }
+        else if (c == '"')
+        {
+            quoted = true;
+        }
+        else if (c == ',')
+        {
+            fields.emplace_back();
+        }
+        else if (c != '\r')
+        {
+            fields.back() += c;
+        }
+    }
+    for (std::string& field : fields)
+    {
+        field = csv_trimmed(field);
+    }
+    return fields;
+}
+
+std::string csv_field(const std::string& text)
+{
+    const bool quoted = text.find_first_of(",\"\r\n") != std::string::npos ||
+        (!text.empty() && (std::isspace(static_cast<unsigned char>(text.front())) ||
+            std::isspace(static_cast<unsigned char>(text.back()))));
+    if (!quoted)
+    {
+        return text;
+    }
+
+    std::string field = "\"";
+    for (char c : text)
+    {
+        field += c;
+        if (c == '"')
+        {
+            field += '"';
+        }
+    }
+    return field + "\"";
+}
+
+} // agromaster
\ No newline at end of file
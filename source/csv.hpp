@@ -0,0 +1,23 @@
+#pragma once
+#ifndef AGROMASTER_CSV_HPP_
+#define AGROMASTER_CSV_HPP_
+
+#include <string>
+#include <vector>
+
+namespace agromaster
+{
+
+// Text without leading and trailing white space.
+std::string csv_trimmed(const std::string& text);
+
+// Trimmed fields of one CSV line; fields may be double quoted, with "" for a literal quote.
+std::vector<std::string> split_csv_line(const std::string& line);
+
+// The text as one CSV field, double quoted when it holds a separator, a quote, a line break
+// or surrounding white space.
+std::string csv_field(const std::string& text);
+
+} // agromaster
+
+#endif // AGROMASTER_CSV_HPP_
\ No newline at end of file
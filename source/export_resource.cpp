@@ -0,0 +1,128 @@
+#include "export_resource.hpp"
+
+#include <limits>
+#include <string>
+
+#include <Wt/Http/ResponseContinuation.h>
+
+#include "catalog_repository.hpp"
+#include "csv.hpp"
+#include "models.hpp"
+
+namespace
+{
+
+// Lets spreadsheet applications recognize the UTF-8 titles; catalog_import skips it.
+constexpr char byte_order_mark[] = "\xEF\xBB\xBF";
+
+constexpr char date_format[] = "yyyy-MM-dd";
+
+std::string date_field(const Wt::WDate& date)
+{
+    return date.isValid() ? date.toString(date_format).toUTF8() : std::string();
+}
+
+// An encoded date set as the ';' separated list catalog_import reads.
+std::string dates_field(const std::string& encoded)
+{
+    std::string list;
+    for (const Wt::WDate& date : agromaster::models::decode_dates(encoded))
+    {
+        if (!list.empty())
+        {
+            list += ';';
+        }
+        list += date_field(date);
+    }
+    return list;
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+constexpr int export_resource::chunk_rows;
+
+export_resource::export_resource(Wt::Dbo::SqlConnectionPool& connection_pool, table exported)
+    : connection_pool_(connection_pool)
+    , table_(exported)
+{
+    suggestFileName(exported == table::hothouses ? "hothouses.csv" : "crops.csv");
+}
+
+export_resource::~export_resource()
+{
+    beingDeleted();
+}
+
+void export_resource::handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+    std::ostream& out = response.out();
+    out.precision(std::numeric_limits<double>::max_digits10);
+
+    long long after_id = 0;
+    if (const Wt::Http::ResponseContinuation* continuation = request.continuation())
+    {
+        after_id = Wt::cpp17::any_cast<long long>(continuation->data());
+    }
+    else
+    {
+        response.setMimeType("text/csv; charset=utf-8");
+        out << byte_order_mark;
+        if (table_ == table::hothouses)
+        {
+            out << "title,crop,yields,spent_fertilizers,sowing,harvest,fertilizer_dates,watering_dates\r\n";
+        }
+        else
+        {
+            out << "title,hothouses,yields,spent_fertilizers,sowing,harvest,fertilizer_dates,watering_dates\r\n";
+        }
+    }
+
+    const long long last_id = table_ == table::hothouses ? write_hothouses(out, after_id) : write_crops(out, after_id);
+    if (last_id > 0)
+    {
+        response.createContinuation()->setData(last_id);
+    }
+}
+
+long long export_resource::write_hothouses(std::ostream& out, long long after_id)
+{
+    const std::vector<models::hothouse_export> hothouses =
+        catalog_repository::hothouse_exports_after(connection_pool_, after_id, chunk_rows);
+
+    for (const models::hothouse_export& hothouse : hothouses)
+    {
+        out << csv_field(hothouse.hothouse.title) << ','
+            << csv_field(hothouse.crop_title) << ','
+            << hothouse.hothouse.yields << ','
+            << hothouse.hothouse.spent_fertilizers << ','
+            << date_field(hothouse.hothouse.sowing) << ','
+            << date_field(hothouse.hothouse.harvest) << ','
+            << dates_field(hothouse.hothouse.fertilizer_dates) << ','
+            << dates_field(hothouse.hothouse.watering_dates) << "\r\n";
+    }
+    return hothouses.size() < static_cast<std::size_t>(chunk_rows) ? 0 : hothouses.back().id;
+}
+
+long long export_resource::write_crops(std::ostream& out, long long after_id)
+{
+    const std::vector<models::crop_export> crops =
+        catalog_repository::crop_exports_after(connection_pool_, after_id, chunk_rows);
+
+    for (const models::crop_export& crop : crops)
+    {
+        out << csv_field(crop.crop.title) << ','
+            << crop.hothouses << ','
+            << crop.yields << ','
+            << crop.spent_fertilizers << ','
+            << date_field(crop.crop.sowing) << ','
+            << date_field(crop.crop.harvest) << ','
+            << dates_field(crop.crop.fertilizer_dates) << ','
+            << dates_field(crop.crop.watering_dates) << "\r\n";
+    }
+    return crops.size() < static_cast<std::size_t>(chunk_rows) ? 0 : crops.back().id;
+}
+
+} // agromaster
\ No newline at end of file
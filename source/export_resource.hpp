@@ -0,0 +1,49 @@
+#pragma once
+#ifndef AGROMASTER_EXPORT_RESOURCE_HPP_
+#define AGROMASTER_EXPORT_RESOURCE_HPP_
+
+#include <ostream>
+
+#include <Wt/Dbo/SqlConnectionPool.h>
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+#include <Wt/WResource.h>
+
+namespace agromaster
+{
+
+// Download of the hothouses or the crops as CSV in the columns catalog_import reads back,
+// plus the hothouse totals of each crop.
+//
+// The rows are streamed with response continuations, chunk_rows rows per continuation,
+// each chunk read by a keyset query in its own short transaction, so neither the server
+// nor the session ever holds more than one chunk whatever the size of the catalog. The
+// resource does not take the session lock, so the UI stays responsive during a download.
+class export_resource final : public Wt::WResource
+{
+public:
+    enum class table
+    {
+        hothouses,
+        crops,
+    };
+
+    static constexpr int chunk_rows = 500;
+
+    export_resource(Wt::Dbo::SqlConnectionPool& connection_pool, table exported);
+    ~export_resource() override;
+
+    void handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+
+private:
+    // Write the rows after after_id and return the id of the last one, 0 past the end.
+    long long write_hothouses(std::ostream& out, long long after_id);
+    long long write_crops(std::ostream& out, long long after_id);
+
+    Wt::Dbo::SqlConnectionPool& connection_pool_;
+    const table table_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_EXPORT_RESOURCE_HPP_
\ No newline at end of file
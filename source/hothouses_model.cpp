@@ -0,0 +1,328 @@
+#include "hothouses_model.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+#include "catalog_cache.hpp"
+
+namespace agromaster
+{
+
+hothouses_model::hothouses_model(catalog_repository& repository, bool editable)
+    : repository_(repository)
+    , editable_(editable)
+{
+}
+
+int hothouses_model::columnCount(const Wt::WModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return editable_ ? delete_column + 1 : works_column + 1;
+}
+
+int hothouses_model::rowCount(const Wt::WModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    if (row_count_ < 0)
+    {
+        row_count_ = repository_.hothouses_count();
+    }
+    return row_count_;
+}
+
+Wt::cpp17::any hothouses_model::data(const Wt::WModelIndex& index, Wt::ItemDataRole role) const
+{
+    if (role == Wt::ItemDataRole::StyleClass)
+    {
+        return Wt::WString(index.column() < works_column ? "text-center" : "btn btn-secondary btn-sm");
+    }
+    if (role != Wt::ItemDataRole::Display && role != Wt::ItemDataRole::User)
+    {
+        return Wt::cpp17::any();
+    }
+
+    const models::hothouse_summary* hothouse = find_row(index.row());
+    if (!hothouse)
+    {
+        return Wt::cpp17::any();
+    }
+    if (role == Wt::ItemDataRole::User)
+    {
+        return hothouse->id;
+    }
+
+    switch (index.column())
+    {
+    case title_column:
+        return Wt::WString(hothouse->title);
+    case crop_column:
+        return Wt::WString(hothouse->crop_id ? hothouse->crop_title : u8" ");
+    case yields_column:
+        return Wt::WString(std::to_string(hothouse->yields));
+    case spent_fertilizers_column:
+        return Wt::WString(std::to_string(hothouse->spent_fertilizers));
+    case works_column:
+        return Wt::WString(u8"");
+    case change_column:
+        return Wt::WString(u8"");
+    case delete_column:
+        return Wt::WString(u8"");
+    default:
+        return Wt::cpp17::any();
+    }
+}
+
+Wt::cpp17::any hothouses_model::headerData(int section, Wt::Orientation orientation, Wt::ItemDataRole role) const
+{
+    if (orientation != Wt::Orientation::Horizontal || role != Wt::ItemDataRole::Display)
+    {
+        return Wt::cpp17::any();
+    }
+
+    switch (section)
+    {
+    case title_column:
+        return Wt::WString(u8"");
+    case crop_column:
+        return Wt::WString(u8"");
+    case yields_column:
+        return Wt::WString(u8", ");
+    case spent_fertilizers_column:
+        return Wt::WString(u8" , ");
+    default:
+        return Wt::WString();
+    }
+}
+
+models::hothouse_summary hothouses_model::hothouse(int row) const
+{
+    const models::hothouse_summary* hothouse = find_row(row);
+    return hothouse ? *hothouse : models::hothouse_summary();
+}
+
+void hothouses_model::reload()
+{
+    row_count_ = -1;
+    pages_.clear();
+    page_last_ids_.clear();
+    reset();
+}
+
+std::set<long long> hothouses_model::cached(const std::set<long long>& ids) const
+{
+    std::set<long long> result;
+    for (const auto& page : pages_)
+    {
+        for (const models::hothouse_summary& hothouse : page.second)
+        {
+            if (ids.count(hothouse.id))
+            {
+                result.insert(hothouse.id);
+            }
+        }
+    }
+    return result;
+}
+
+std::size_t hothouses_model::memory_bytes() const
+{
+    std::size_t bytes = 0;
+    for (const auto& page : pages_)
+    {
+        bytes += page.second.capacity() * sizeof(models::hothouse_summary);
+        for (const models::hothouse_summary& hothouse : page.second)
+        {
+            bytes += hothouse.title.capacity() + hothouse.crop_title.capacity();
+        }
+    }
+    return bytes;
+}
+
+void hothouses_model::insert_rows(int count)
+{
+    if (count <= 0 || row_count_ < 0)
+    {
+        return;
+    }
+
+    // New hothouses get the largest ids, so they are always appended after the last row.
+    const int first = row_count_;
+    beginInsertRows(Wt::WModelIndex(), first, first + count - 1);
+    row_count_ += count;
+    drop_pages_from(first / page_size);
+    endInsertRows();
+}
+
+void hothouses_model::update_rows(const std::vector<models::hothouse_summary>& hothouses)
+{
+    for (const models::hothouse_summary& hothouse : hothouses)
+    {
+        int row = 0;
+        models::hothouse_summary* cached_hothouse = locate(hothouse.id, row);
+        if (cached_hothouse)
+        {
+            *cached_hothouse = hothouse;
+            dataChanged().emit(index(row, title_column), index(row, columnCount() - 1));
+        }
+    }
+}
+
+void hothouses_model::remove_rows(const std::set<long long>& ids)
+{
+    for (long long id : ids)
+    {
+        int row = 0;
+        if (!locate(id, row))
+        {
+            // The position of a row that was never fetched is unknown.
+            reload();
+            return;
+        }
+
+        beginRemoveRows(Wt::WModelIndex(), row, row);
+        --row_count_;
+        drop_pages_from(row / page_size);
+        endRemoveRows();
+    }
+}
+
+void hothouses_model::update_crop(long long crop_id, const std::string& crop_title)
+{
+    for (auto& page : pages_)
+    {
+        for (std::size_t offset = 0; offset < page.second.size(); ++offset)
+        {
+            models::hothouse_summary& hothouse = page.second[offset];
+            if (hothouse.crop_id == crop_id && hothouse.crop_title != crop_title)
+            {
+                hothouse.crop_title = crop_title;
+                const int row = page.first * page_size + static_cast<int>(offset);
+                dataChanged().emit(index(row, crop_column), index(row, crop_column));
+            }
+        }
+    }
+}
+
+void hothouses_model::remove_crop(long long crop_id)
+{
+    for (auto& page : pages_)
+    {
+        for (std::size_t offset = 0; offset < page.second.size(); ++offset)
+        {
+            models::hothouse_summary& hothouse = page.second[offset];
+            if (hothouse.crop_id == crop_id)
+            {
+                hothouse.crop_id = 0;
+                hothouse.crop_title.clear();
+                const int row = page.first * page_size + static_cast<int>(offset);
+                dataChanged().emit(index(row, crop_column), index(row, crop_column));
+            }
+        }
+    }
+}
+
+const models::hothouse_summary* hothouses_model::find_row(int row) const
+{
+    if (row < 0 || row >= rowCount())
+    {
+        return nullptr;
+    }
+
+    const int page = row / page_size;
+    auto it = pages_.find(page);
+    if (it == pages_.end())
+    {
+        fetch(page);
+        it = pages_.find(page);
+    }
+
+    const std::size_t offset = row % page_size;
+    if (it == pages_.end() || offset >= it->second.size())
+    {
+        return nullptr;
+    }
+    return &it->second[offset];
+}
+
+void hothouses_model::fetch(int page) const
+{
+    constexpr int limit = page_size * (1 + prefetch_pages);
+
+    catalog_cache::hothouses_type rows;
+    auto boundary = page_last_ids_.find(page - 1);
+    if (page == 0)
+    {
+        rows = repository_.hothouses_after(0, limit);
+    }
+    else if (boundary != page_last_ids_.end())
+    {
+        rows = repository_.hothouses_after(boundary->second, limit);
+    }
+    else
+    {
+        rows = repository_.hothouses_from(page * page_size, limit);
+    }
+
+    evict_pages(page);
+
+    pages_[page];
+    for (std::size_t first = 0; first < rows->size(); first += page_size)
+    {
+        const std::size_t last = std::min(first + page_size, rows->size());
+        const int current = page + static_cast<int>(first / page_size);
+        std::vector<models::hothouse_summary>& cached = pages_[current];
+        cached.assign(rows->begin() + first, rows->begin() + last);
+        page_last_ids_[current] = cached.back().id;
+    }
+}
+
+models::hothouse_summary* hothouses_model::locate(long long id, int& row)
+{
+    for (auto& page : pages_)
+    {
+        std::vector<models::hothouse_summary>& hothouses = page.second;
+        auto it = std::lower_bound(hothouses.begin(), hothouses.end(), id,
+            [](const models::hothouse_summary& hothouse, long long value)
+        {
+            return hothouse.id < value;
+        });
+        if (it != hothouses.end() && it->id == id)
+        {
+            row = page.first * page_size + static_cast<int>(it - hothouses.begin());
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+void hothouses_model::drop_pages_from(int page)
+{
+    pages_.erase(pages_.lower_bound(page), pages_.end());
+    page_last_ids_.erase(page_last_ids_.lower_bound(page), page_last_ids_.end());
+}
+
+void hothouses_model::evict_pages(int page) const
+{
+    while (!pages_.empty() && pages_.size() + 1 + prefetch_pages > max_cached_pages)
+    {
+        auto first = pages_.begin();
+        auto last = std::prev(pages_.end());
+        if (page - first->first > last->first - page)
+        {
+            pages_.erase(first);
+        }
+        else
+        {
+            pages_.erase(last);
+        }
+    }
+}
+
+} // agromaster
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#ifndef AGROMASTER_HOTHOUSES_MODEL_HPP_
+#define AGROMASTER_HOTHOUSES_MODEL_HPP_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Wt/WAbstractTableModel.h>
+
+#include "catalog_repository.hpp"
+#include "models.hpp"
+
+namespace agromaster
+{
+
+// Read-only table model over the hothouses that fetches rows lazily, page by page.
+// Pages are loaded with keyset pagination on the primary key whenever the previous
+// page boundary is known, and with an offset otherwise, through catalog_repository and
+// the catalog_cache it shares between sessions. Only a bounded window of pages around
+// the rows requested by the view is kept in memory.
+class hothouses_model final : public Wt::WAbstractTableModel
+{
+public:
+    enum column
+    {
+        title_column = 0,
+        crop_column,
+        yields_column,
+        spent_fertilizers_column,
+        works_column,
+        change_column,
+        delete_column
+    };
+
+    static constexpr int page_size = 50;
+    static constexpr int prefetch_pages = 1;
+    static constexpr std::size_t max_cached_pages = 8;
+
+    hothouses_model(catalog_repository& repository, bool editable);
+
+    int columnCount(const Wt::WModelIndex& parent = Wt::WModelIndex()) const override;
+    int rowCount(const Wt::WModelIndex& parent = Wt::WModelIndex()) const override;
+    Wt::cpp17::any data(const Wt::WModelIndex& index, Wt::ItemDataRole role = Wt::ItemDataRole::Display) const override;
+    Wt::cpp17::any headerData(
+        int section,
+        Wt::Orientation orientation = Wt::Orientation::Horizontal,
+        Wt::ItemDataRole role = Wt::ItemDataRole::Display) const override;
+
+    models::hothouse_summary hothouse(int row) const;
+    void reload();
+
+    // Row level patches. Each of them touches only the cached pages and issues no queries;
+    // rows that are not cached are fetched fresh once the view scrolls to them.
+    std::set<long long> cached(const std::set<long long>& ids) const;
+    void insert_rows(int count);
+    void update_rows(const std::vector<models::hothouse_summary>& hothouses);
+    void remove_rows(const std::set<long long>& ids);
+    void update_crop(long long crop_id, const std::string& crop_title);
+    void remove_crop(long long crop_id);
+
+    // Bytes held by the cached rows, for the memory accounting of the session.
+    std::size_t memory_bytes() const;
+
+private:
+    const models::hothouse_summary* find_row(int row) const;
+    models::hothouse_summary* locate(long long id, int& row);
+    void drop_pages_from(int page);
+    void fetch(int page) const;
+    void evict_pages(int page) const;
+
+    catalog_repository& repository_;
+    bool editable_;
+    mutable int row_count_ = -1;
+    mutable std::map<int, std::vector<models::hothouse_summary>> pages_;
+    mutable std::map<int, long long> page_last_ids_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_HOTHOUSES_MODEL_HPP_
\ No newline at end of file
@@ -0,0 +1,450 @@
+#include "ingest_resource.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <set>
+#include <thread>
+#include <utility>
+
+#include <Wt/Dbo/Transaction.h>
+#include <Wt/Json/Array.h>
+#include <Wt/Json/Object.h>
+#include <Wt/Json/Parser.h>
+#include <Wt/Json/Serializer.h>
+#include <Wt/Json/Value.h>
+#include <Wt/WLogger.h>
+#include <Wt/WString.h>
+
+#include "bearer_token.hpp"
+#include "catalog_cache.hpp"
+#include "change_bus.hpp"
+#include "configuration.hpp"
+#include "connection_pool.hpp"
+#include "csv.hpp"
+#include "metrics.hpp"
+#include "models.hpp"
+#include "validation.hpp"
+
+namespace
+{
+
+using agromaster::models::hothouse_reading;
+
+// Errors listed in a 400 response; the rest are only counted.
+constexpr std::size_t max_reported_errors = 20;
+
+constexpr char hothouse_key[] = "hothouse";
+constexpr char yields_key[] = "yields";
+constexpr char spent_fertilizers_key[] = "spent_fertilizers";
+
+// Readings of one request, summed per hothouse, and what was wrong with the rest.
+class parsed_batch
+{
+public:
+    explicit parsed_batch(std::size_t max_records)
+        : max_records_(max_records)
+    {
+    }
+
+    // Returns false once the batch is full; the caller stops reading then.
+    bool add(const std::string& where, const hothouse_reading& reading)
+    {
+        if (++records_ > max_records_)
+        {
+            too_large_ = true;
+            return false;
+        }
+        if (reading.hothouse.empty())
+        {
+            error(where + ": hothouse is empty");
+            return true;
+        }
+        if (Wt::WString::fromUTF8(reading.hothouse).value().size() > agromaster::max_title_length)
+        {
+            error(where + ": hothouse '" + reading.hothouse + "' is longer than " +
+                std::to_string(agromaster::max_title_length) + " characters");
+            return true;
+        }
+
+        auto position = positions_.find(reading.hothouse);
+        if (position == positions_.end())
+        {
+            positions_.emplace(reading.hothouse, readings_.size());
+            readings_.push_back(reading);
+        }
+        else
+        {
+            hothouse_reading& sum = readings_[position->second];
+            sum.yields += reading.yields;
+            sum.spent_fertilizers += reading.spent_fertilizers;
+        }
+        return true;
+    }
+
+    void error(const std::string& message)
+    {
+        if (errors_.size() < max_reported_errors)
+        {
+            errors_.push_back(message);
+        }
+        ++error_count_;
+    }
+
+    std::size_t records() const { return std::min(records_, max_records_); }
+    bool too_large() const { return too_large_; }
+    std::size_t error_count() const { return error_count_; }
+    const std::vector<std::string>& errors() const { return errors_; }
+    std::vector<hothouse_reading>& readings() { return readings_; }
+
+private:
+    std::size_t max_records_;
+    std::size_t records_ = 0;
+    bool too_large_ = false;
+    std::size_t error_count_ = 0;
+    std::vector<std::string> errors_;
+    std::vector<hothouse_reading> readings_;
+    std::map<std::string, std::size_t> positions_;
+};
+
+void parse_csv(std::istream& in, parsed_batch& batch)
+{
+    std::string line;
+    if (!std::getline(in, line))
+    {
+        batch.error("line 1: missing header");
+        return;
+    }
+
+    int hothouse_column = -1;
+    int yields_column = -1;
+    int spent_fertilizers_column = -1;
+    const std::vector<std::string> header = split_csv_line(line);
+    for (std::size_t column = 0; column < header.size(); ++column)
+    {
+        if (header[column] == hothouse_key)
+        {
+            hothouse_column = static_cast<int>(column);
+        }
+        else if (header[column] == yields_key)
+        {
+            yields_column = static_cast<int>(column);
+        }
+        else if (header[column] == spent_fertilizers_key)
+        {
+            spent_fertilizers_column = static_cast<int>(column);
+        }
+        else
+        {
+            batch.error("line 1: unknown column '" + header[column] + "'");
+        }
+    }
+    if (hothouse_column < 0)
+    {
+        batch.error("line 1: no hothouse column");
+        return;
+    }
+
+    for (std::size_t number = 2; std::getline(in, line); ++number)
+    {
+        if (csv_trimmed(line).empty())
+        {
+            continue;
+        }
+        const std::string where = "line " + std::to_string(number);
+        const std::vector<std::string> fields = split_csv_line(line);
+        if (fields.size() != header.size())
+        {
+            batch.error(where + ": expected " + std::to_string(header.size()) + " fields");
+            continue;
+        }
+
+        hothouse_reading reading;
+        reading.hothouse = fields[hothouse_column];
+        if ((yields_column >= 0 && !parse_quantity(fields[yields_column], reading.yields)) ||
+            (spent_fertilizers_column >= 0 && !parse_quantity(fields[spent_fertilizers_column], reading.spent_fertilizers)))
+        {
+            batch.error(where + ": quantities must be non-negative numbers");
+            continue;
+        }
+        if (!batch.add(where, reading))
+        {
+            return;
+        }
+    }
+}
+
+bool json_quantity(const Wt::Json::Object& record, const char* key, double& quantity)
+{
+    const Wt::Json::Value& value = record.get(key);
+    if (value.isNull())
+    {
+        quantity = 0.0;
+        return true;
+    }
+    if (value.type() != Wt::Json::Type::Number)
+    {
+        return false;
+    }
+    quantity = static_cast<double>(value);
+    return std::isfinite(quantity) && quantity >= 0.0;
+}
+
+void parse_json(std::istream& in, parsed_batch& batch)
+{
+    const std::string body((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    Wt::Json::Array records;
+    try
+    {
+        Wt::Json::parse(body, records);
+    }
+    catch (const Wt::Json::ParseError& error)
+    {
+        batch.error(std::string("body is not a JSON array: ") + error.what());
+        return;
+    }
+
+    for (std::size_t index = 0; index < records.size(); ++index)
+    {
+        const std::string where = "record " + std::to_string(index);
+        if (records[index].type() != Wt::Json::Type::Object)
+        {
+            batch.error(where + ": not an object");
+            continue;
+        }
+        const Wt::Json::Object& record = records[index];
+        const Wt::Json::Value& hothouse = record.get(hothouse_key);
+        if (hothouse.type() != Wt::Json::Type::String)
+        {
+            batch.error(where + ": hothouse must be a string");
+            continue;
+        }
+
+        hothouse_reading reading;
+        reading.hothouse = csv_trimmed(static_cast<const Wt::WString&>(hothouse).toUTF8());
+        if (!json_quantity(record, yields_key, reading.yields) ||
+            !json_quantity(record, spent_fertilizers_key, reading.spent_fertilizers))
+        {
+            batch.error(where + ": quantities must be non-negative numbers");
+            continue;
+        }
+        if (!batch.add(where, reading))
+        {
+            return;
+        }
+    }
+}
+
+void reply(Wt::Http::Response& response, int status, const Wt::Json::Object& body)
+{
+    response.setStatus(status);
+    response.setMimeType("application/json");
+    response.out() << Wt::Json::serialize(body);
+}
+
+void reply_error(Wt::Http::Response& response, int status, const std::string& message)
+{
+    Wt::Json::Object body;
+    body["error"] = Wt::Json::Value(Wt::WString::fromUTF8(message));
+    reply(response, status, body);
+}
+
+bool has_media_type(const std::string& content_type, const std::string& media_type)
+{
+    return content_type.compare(0, media_type.size(), media_type) == 0 &&
+        (content_type.size() == media_type.size() || content_type[media_type.size()] == ';');
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+ingest_resource::settings ingest_resource::settings::load(const Wt::WServer& server)
+{
+    using namespace configuration;
+
+    settings config;
+    config.tokens = load_bearer_tokens(server);
+    read_number(server, "AGROMASTER_INGEST_MAX_RECORDS", "agromaster-ingest-max-records", config.max_records);
+    read_number(server, "AGROMASTER_INGEST_BATCH_SIZE", "agromaster-ingest-batch-size", config.batch_size);
+    read_number(server, "AGROMASTER_INGEST_MAX_ATTEMPTS", "agromaster-ingest-max-attempts", config.max_attempts);
+    read_duration(server, "AGROMASTER_INGEST_RETRY_DELAY", "agromaster-ingest-retry-delay", config.retry_delay);
+    config.batch_size = std::max<std::size_t>(config.batch_size, 1);
+    config.max_attempts = std::max<std::size_t>(config.max_attempts, 1);
+    return config;
+}
+
+ingest_resource::ingest_resource(Wt::Dbo::SqlConnectionPool& connection_pool, worker_pool& workers, settings config)
+    : connection_pool_(connection_pool)
+    , workers_(workers)
+    , settings_(std::move(config))
+{
+    if (settings_.tokens.empty())
+    {
+        Wt::log("warning") << "ingest_resource: no agromaster-ingest-tokens configured, every request is refused";
+    }
+}
+
+ingest_resource::~ingest_resource()
+{
+    beingDeleted();
+}
+
+void ingest_resource::handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+    if (request.method() != "POST")
+    {
+        response.addHeader("Allow", "POST");
+        reply_error(response, 405, "use POST");
+        return;
+    }
+    if (!has_bearer_token(request, settings_.tokens))
+    {
+        response.addHeader("WWW-Authenticate", "Bearer");
+        reply_error(response, 401, "missing or unknown token");
+        return;
+    }
+
+    parsed_batch batch(settings_.max_records);
+    const std::string content_type = request.contentType();
+    if (has_media_type(content_type, "text/csv"))
+    {
+        parse_csv(request.in(), batch);
+    }
+    else if (has_media_type(content_type, "application/json"))
+    {
+        parse_json(request.in(), batch);
+    }
+    else
+    {
+        reply_error(response, 415, "send text/csv or application/json");
+        return;
+    }
+
+    if (batch.too_large())
+    {
+        reply_error(response, 413, "more than " + std::to_string(settings_.max_records) + " records");
+        return;
+    }
+    if (batch.error_count() > 0)
+    {
+        Wt::Json::Array errors;
+        for (const std::string& error : batch.errors())
+        {
+            errors.push_back(Wt::Json::Value(Wt::WString::fromUTF8(error)));
+        }
+        Wt::Json::Object body;
+        body["error_count"] = Wt::Json::Value(static_cast<long long>(batch.error_count()));
+        body["errors"] = Wt::Json::Value(std::move(errors));
+        reply(response, 400, body);
+        return;
+    }
+
+    const std::uint64_t number = next_batch_++;
+    const std::size_t hothouses = batch.readings().size();
+    const bool queued = workers_.submit(
+        [this, number, readings = std::move(batch.readings())]
+    {
+        apply(number, readings);
+    });
+    if (!queued)
+    {
+        response.addHeader("Retry-After", "5");
+        reply_error(response, 503, "too many batches waiting, retry later");
+        return;
+    }
+
+    Wt::Json::Object body;
+    body["batch"] = Wt::Json::Value(static_cast<long long>(number));
+    body["records"] = Wt::Json::Value(static_cast<long long>(batch.records()));
+    body["hothouses"] = Wt::Json::Value(static_cast<long long>(hothouses));
+    reply(response, 202, body);
+}
+
+void ingest_resource::apply(std::uint64_t batch, const std::vector<models::hothouse_reading>& readings)
+{
+    const metrics::handler_scope scope("ingest_readings");
+    models::session session(connection_pool_);
+    change_set changes;
+    std::size_t unknown = 0;
+    std::size_t failed = 0;
+    for (std::size_t first = 0; first < readings.size(); first += settings_.batch_size)
+    {
+        const std::size_t last = std::min(first + settings_.batch_size, readings.size());
+        const std::vector<models::hothouse_reading> chunk(readings.begin() + first, readings.begin() + last);
+        if (!apply_chunk(batch, session, chunk, changes, unknown))
+        {
+            failed += chunk.size();
+        }
+    }
+
+    if (unknown > 0)
+    {
+        Wt::log("warning") << "ingest_resource: batch " << batch << " named " << unknown << " unknown hothouses";
+    }
+    Wt::log("info") << "ingest_resource: batch " << batch << " updated " << changes.changed_hothouses.size()
+        << " hothouses";
+    if (failed > 0)
+    {
+        Wt::log("error") << "ingest_resource: batch " << batch << " lost " << failed << " hothouse readings";
+    }
+
+    if (!changes.empty())
+    {
+        catalog_cache::instance().invalidate();
+        change_bus::instance().publish(changes, std::string());
+    }
+}
+
+bool ingest_resource::apply_chunk(
+    std::uint64_t batch,
+    models::session& session,
+    const std::vector<models::hothouse_reading>& chunk,
+    change_set& changes,
+    std::size_t& unknown)
+{
+    std::chrono::milliseconds delay = settings_.retry_delay;
+    for (std::size_t attempt = 1; ; ++attempt)
+    {
+        try
+        {
+            // One operation per chunk, so a long batch does not run out of its deadline.
+            const connection_pool::admission admission(connection_pool::priority::bulk);
+            std::set<long long> hothouse_ids;
+            std::set<long long> crop_ids;
+            Wt::Dbo::Transaction transaction(session);
+            const std::vector<std::string> missing = session.add_hothouse_readings(chunk, hothouse_ids, crop_ids);
+            transaction.commit();
+
+            unknown += missing.size();
+            changes.changed_hothouses.insert(hothouse_ids.begin(), hothouse_ids.end());
+            changes.changed_crops.insert(crop_ids.begin(), crop_ids.end());
+            return true;
+        }
+        catch (const std::exception& error)
+        {
+            if (attempt == settings_.max_attempts)
+            {
+                Wt::log("error") << "ingest_resource: batch " << batch << " gave up on " << chunk.size()
+                    << " hothouse readings after " << attempt << " attempts: " << error.what();
+                break;
+            }
+            Wt::log("warning") << "ingest_resource: batch " << batch << " attempt " << attempt
+                << " failed, retrying in " << delay.count() << " ms: " << error.what();
+        }
+        // The rolled back transaction applied nothing, so the whole chunk is applied again.
+        std::this_thread::sleep_for(delay);
+        delay *= 2;
+    }
+
+    for (const models::hothouse_reading& reading : chunk)
+    {
+        Wt::log("error") << "ingest_resource: batch " << batch << " lost reading hothouse='" << reading.hothouse
+            << "' yields=" << reading.yields << " spent_fertilizers=" << reading.spent_fertilizers;
+    }
+    return false;
+}
+
+} // agromaster
\ No newline at end of file
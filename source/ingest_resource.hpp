@@ -0,0 +1,81 @@
+#pragma once
+#ifndef AGROMASTER_INGEST_RESOURCE_HPP_
+#define AGROMASTER_INGEST_RESOURCE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Wt/Dbo/SqlConnectionPool.h>
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+#include <Wt/WResource.h>
+#include <Wt/WServer.h>
+
+#include "change_set.hpp"
+#include "models.hpp"
+#include "models/hothouse_reading.hpp"
+#include "worker_pool.hpp"
+
+namespace agromaster
+{
+
+// Bulk endpoint for weighing stations and dosing controllers.
+//
+// A POST carries a batch of readings, either as text/csv with a header line naming the
+// hothouse, yields and spent_fertilizers columns, or as an application/json array of
+// objects with the same keys; absent quantities count as 0. Callers authenticate with
+// "Authorization: Bearer <token>" using one of the configured tokens.
+//
+// CSV bodies are validated line by line while they are read, JSON bodies in one pass
+// over the parsed array. Readings for the same hothouse are summed, so a batch updates
+// each hothouse once. A valid batch is answered
+// with 202 and applied later on the ingest workers, batch_size hothouses per transaction;
+// an invalid one is rejected as a whole with 400 and the first errors found. Bodies
+// larger than the max-request-size of the Wt configuration are refused by Wt itself.
+//
+// A transaction that fails is rolled back whole, so its chunk is retried on the worker up
+// to max_attempts times, waiting retry_delay and then twice as long each time. Readings
+// still failing after that are logged one by one, so they can be applied by hand.
+class ingest_resource final : public Wt::WResource
+{
+public:
+    struct settings
+    {
+        std::vector<std::string> tokens;
+        std::size_t max_records = 100000;
+        std::size_t batch_size = 500;
+        std::size_t max_attempts = 5;
+        std::chrono::milliseconds retry_delay{ 1000 };
+
+        // Tokens come from load_bearer_tokens().
+        static settings load(const Wt::WServer& server);
+    };
+
+    ingest_resource(Wt::Dbo::SqlConnectionPool& connection_pool, worker_pool& workers, settings config);
+    ~ingest_resource() override;
+
+    void handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+
+private:
+    void apply(std::uint64_t batch, const std::vector<models::hothouse_reading>& readings);
+    // Returns false when the chunk failed every attempt.
+    bool apply_chunk(
+        std::uint64_t batch,
+        models::session& session,
+        const std::vector<models::hothouse_reading>& chunk,
+        change_set& changes,
+        std::size_t& unknown);
+
+    Wt::Dbo::SqlConnectionPool& connection_pool_;
+    worker_pool& workers_;
+    const settings settings_;
+    std::atomic<std::uint64_t> next_batch_{ 1 };
+};
+
+} // agromaster
+
+#endif // AGROMASTER_INGEST_RESOURCE_HPP_
\ No newline at end of file
@@ -1,35 +1,28 @@
 #include "application.hpp"
+#include "bearer_token.hpp"
+#include "climate_resource.hpp"
+#include "climate_writer.hpp"
+#include "connection_pool.hpp"
+#include "ingest_resource.hpp"
+#include "metrics_resource.hpp"
+#include "models/migrations.hpp"
+#include "sql_monitor.hpp"
+#include "worker_pool.hpp"
 
-void create_database(Wt::Dbo::SqlConnectionPool& pool)
-{
-    using namespace agromaster;
-
-    models::session session(pool);
-
-    try
-    {
-        session.createTables();
+#include <algorithm>
+#include <memory>
+#include <thread>
 
-        Wt::Dbo::Transaction transaction(session);
-        Wt::Auth::User admin = session.users().registerNew();
-        admin.addIdentity(Wt::Auth::Identity::LoginName, "admin");
-        session.users().setPassword(admin, models::session::password_auth().verifier()->hashPassword("admin"));
+// Logins beyond this many waiting password checks are asked to retry.
+constexpr std::size_t max_queued_password_checks = 256;
 
-        Wt::Dbo::ptr<agromaster::models::AuthInfo> auth_info = session.users().find(admin);
-        Wt::Dbo::ptr<models::user_account> user_acc = auth_info->user();
-        if (!user_acc) {
-            user_acc = session.add(std::make_unique<models::user_account>(models::user_account::role::admin));
-            auth_info.modify()->setUser(user_acc);
-        }
+// Ingest batches beyond this many waiting ones are answered with 503.
+constexpr std::size_t max_queued_ingest_batches = 64;
 
-        std::clog << "Created database." << std::endl;
-    }
-    catch (Wt::Dbo::Exception& error)
-    {
-        std::clog
-            << error.what() << '\n'
-            << "Using existing database" << std::endl;
-    }
+void migrate_database(Wt::Dbo::SqlConnectionPool& pool)
+{
+    agromaster::models::session session(pool);
+    agromaster::models::migrate(session);
 }
 
 int main(int argc, char* argv[])
@@ -39,16 +32,39 @@ int main(int argc, char* argv[])
 
         agromaster::models::session::configure_auth();
 
-        auto connection = std::make_unique<Wt::Dbo::backend::Postgres>(
-            "host=localhost password=example dbname=agronomy user=postgres");
+        agromaster::sql_monitor::configure(agromaster::sql_monitor::settings::load(server));
+
+        const auto pool_settings = agromaster::connection_pool::settings::load(server);
+        const agromaster::connection_pool::connector connect =
+            [connection_string = pool_settings.connection_string]
+        {
+            return std::make_unique<agromaster::instrumented_connection<Wt::Dbo::backend::Postgres>>(connection_string);
+        };
+
+        // The climate writer gets a connection of its own, away from the pool of the UI.
+        Wt::Dbo::FixedSqlConnectionPool climate_pool(connect(), 1);
+        auto connection_pool = std::make_unique<agromaster::connection_pool>(connect, pool_settings);
+        migrate_database(*connection_pool);
+        agromaster::climate_writer climate_writer(climate_pool, agromaster::climate_writer::settings::load(server));
+
+        // bcrypt keeps a core busy for the whole check, so logins get about half of them.
+        const std::size_t password_threads = std::max(2u, std::thread::hardware_concurrency() / 2);
+        agromaster::worker_pool password_workers(password_threads, max_queued_password_checks);
 
-        auto connection_pool = std::make_unique<Wt::Dbo::FixedSqlConnectionPool>(std::move(connection), 10);
-        create_database(*connection_pool);
+        // A single writer applies the batches in arrival order without contending for rows.
+        agromaster::worker_pool ingest_workers(1, max_queued_ingest_batches);
 
+        server.addResource(std::make_shared<agromaster::metrics_resource>(*connection_pool, climate_writer), "/metrics");
+        server.addResource(std::make_shared<agromaster::ingest_resource>(*connection_pool, ingest_workers,
+            agromaster::ingest_resource::settings::load(server)), "/api/readings");
+        server.addResource(std::make_shared<agromaster::climate_resource>(climate_writer, *connection_pool,
+            agromaster::load_bearer_tokens(server)), "/api/climate");
+        const auto application_settings = agromaster::application::settings::load(server);
         server.addEntryPoint(Wt::EntryPointType::Application,
-            [&connection_pool](const Wt::WEnvironment& env)
+            [&connection_pool, &password_workers, application_settings](const Wt::WEnvironment& env)
         {
-            return std::make_unique<agromaster::application>(env, *connection_pool);
+            return std::make_unique<agromaster::application>(
+                env, *connection_pool, password_workers, application_settings);
         });
 
         server.run();
@@ -0,0 +1,178 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+
+#include "sql_monitor.hpp"
+
+namespace
+{
+
+thread_local const char* current_handler = nullptr;
+
+double to_seconds(agromaster::metrics::duration elapsed)
+{
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+void write_header(std::ostream& out, const char* name, const char* type, const char* help)
+{
+    out << "# HELP " << name << ' ' << help << '\n'
+        << "# TYPE " << name << ' ' << type << '\n';
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+constexpr std::array<double, 13> metrics::bucket_bounds;
+
+metrics::handler_scope::handler_scope(const char* handler)
+    : handler_(handler)
+    , outer_(current_handler)
+    , started_(std::chrono::steady_clock::now())
+    , statements_before_(sql_monitor::thread_statements())
+{
+    current_handler = handler_;
+}
+
+metrics::handler_scope::~handler_scope()
+{
+    current_handler = outer_;
+    const duration elapsed = std::chrono::steady_clock::now() - started_;
+    const std::uint64_t statements = sql_monitor::thread_statements() - statements_before_;
+    metrics::instance().observe_handler(handler_, elapsed, statements);
+    if (!outer_)
+    {
+        sql_monitor::action_finished(handler_, statements, elapsed);
+    }
+}
+
+const char* metrics::handler_scope::current()
+{
+    return current_handler;
+}
+
+metrics& metrics::instance()
+{
+    static metrics registry;
+    return registry;
+}
+
+void metrics::session_started()
+{
+    ++active_sessions_;
+    ++sessions_total_;
+}
+
+void metrics::session_ended(const std::string& session_key)
+{
+    --active_sessions_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    session_footprints_.erase(session_key);
+}
+
+void metrics::observe_session_footprint(const std::string& session_key, const session_footprint& footprint)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    session_footprints_[session_key] = footprint;
+}
+
+void metrics::observe_request(duration elapsed)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.observe(elapsed);
+}
+
+void metrics::observe_handler(const std::string& handler, duration elapsed, std::uint64_t statements)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    handlers_[handler].observe(elapsed);
+    handler_statements_[handler] += statements;
+}
+
+void metrics::observe_transaction(duration elapsed)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    transactions_.observe(elapsed);
+}
+
+void metrics::write(std::ostream& out) const
+{
+    write_header(out, "agromaster_active_sessions", "gauge", "Sessions currently alive.");
+    out << "agromaster_active_sessions " << active_sessions_.load() << '\n';
+    write_header(out, "agromaster_sessions_total", "counter", "Sessions started since the server started.");
+    out << "agromaster_sessions_total " << sessions_total_.load() << '\n';
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_header(out, "agromaster_request_duration_seconds", "histogram",
+        "Time to handle one request of a session, event handling and rendering included.");
+    requests_.write(out, "agromaster_request_duration_seconds", "");
+
+    write_header(out, "agromaster_handler_duration_seconds", "histogram", "Time spent in each application handler.");
+    for (const auto& handler : handlers_)
+    {
+        handler.second.write(out, "agromaster_handler_duration_seconds", "handler=\"" + handler.first + "\"");
+    }
+
+    write_header(out, "agromaster_handler_statements_total", "counter",
+        "SQL statements run by each application handler, nested handlers included.");
+    for (const auto& handler : handler_statements_)
+    {
+        out << "agromaster_handler_statements_total{handler=\"" << handler.first << "\"} " << handler.second << '\n';
+    }
+
+    std::size_t widgets = 0;
+    std::size_t max_widgets = 0;
+    std::size_t model_bytes = 0;
+    for (const auto& session : session_footprints_)
+    {
+        widgets += session.second.widgets;
+        max_widgets = std::max(max_widgets, session.second.widgets);
+        model_bytes += session.second.model_bytes;
+    }
+    write_header(out, "agromaster_session_widgets", "gauge", "Widgets held by the live sessions, as last measured.");
+    out << "agromaster_session_widgets " << widgets << '\n';
+    write_header(out, "agromaster_session_widgets_max", "gauge", "Widgets held by the largest live session.");
+    out << "agromaster_session_widgets_max " << max_widgets << '\n';
+    write_header(out, "agromaster_session_model_bytes", "gauge",
+        "Bytes of the table rows the live sessions keep, shared catalog snapshots excluded.");
+    out << "agromaster_session_model_bytes " << model_bytes << '\n';
+
+    write_header(out, "agromaster_transaction_duration_seconds", "histogram",
+        "Time a database transaction held its pooled connection.");
+    transactions_.write(out, "agromaster_transaction_duration_seconds", "");
+}
+
+void metrics::histogram::observe(duration elapsed)
+{
+    const double seconds = to_seconds(elapsed);
+    for (std::size_t i = 0; i < bucket_bounds.size(); ++i)
+    {
+        if (seconds <= bucket_bounds[i])
+        {
+            ++buckets[i];
+            break;
+        }
+    }
+    ++count;
+    sum += seconds;
+}
+
+void metrics::histogram::write(std::ostream& out, const std::string& name, const std::string& labels) const
+{
+    const std::string separator = labels.empty() ? "" : ",";
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < bucket_bounds.size(); ++i)
+    {
+        cumulative += buckets[i];
+        out << name << "_bucket{" << labels << separator << "le=\"" << bucket_bounds[i] << "\"} " << cumulative << '\n';
+    }
+    out << name << "_bucket{" << labels << separator << "le=\"+Inf\"} " << count << '\n';
+
+    const std::string label_set = labels.empty() ? "" : "{" + labels + "}";
+    out << name << "_sum" << label_set << ' ' << sum << '\n'
+        << name << "_count" << label_set << ' ' << count << '\n';
+}
+
+} // agromaster
\ No newline at end of file
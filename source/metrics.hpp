@@ -0,0 +1,101 @@
+#pragma once
+#ifndef AGROMASTER_METRICS_HPP_
+#define AGROMASTER_METRICS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace agromaster
+{
+
+// Process wide counters and latency histograms, written out in the Prometheus text format
+// by metrics_resource.
+class metrics
+{
+public:
+    using duration = std::chrono::steady_clock::duration;
+
+    // Times the enclosing handler into the per-handler histogram and makes it the current
+    // handler of this thread until the scope ends; nested scopes restore the outer one.
+    // The outermost scope is one user action, whose SQL statements are checked by
+    // sql_monitor.
+    class handler_scope
+    {
+    public:
+        explicit handler_scope(const char* handler);
+        ~handler_scope();
+
+        handler_scope(const handler_scope&) = delete;
+        handler_scope& operator=(const handler_scope&) = delete;
+
+        // Innermost handler running on this thread, nullptr outside any handler.
+        static const char* current();
+
+    private:
+        const char* handler_;
+        const char* outer_;
+        std::chrono::steady_clock::time_point started_;
+        std::uint64_t statements_before_;
+    };
+
+    // Estimated memory of one session: the widgets in its tree and the bytes of the rows
+    // its models keep.
+    struct session_footprint
+    {
+        std::size_t widgets = 0;
+        std::size_t model_bytes = 0;
+    };
+
+    static metrics& instance();
+
+    void session_started();
+    // Sessions are identified by a key that stays the same for their whole life; a session
+    // id changes at login.
+    void session_ended(const std::string& session_key);
+    // Replaces the last footprint reported by the session.
+    void observe_session_footprint(const std::string& session_key, const session_footprint& footprint);
+
+    void observe_request(duration elapsed);
+    void observe_handler(const std::string& handler, duration elapsed, std::uint64_t statements);
+    void observe_transaction(duration elapsed);
+
+    void write(std::ostream& out) const;
+
+private:
+    // Upper bounds in seconds; the implicit last bucket is +Inf.
+    static constexpr std::array<double, 13> bucket_bounds{
+        { 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0 } };
+
+    struct histogram
+    {
+        std::array<std::uint64_t, bucket_bounds.size()> buckets{};
+        std::uint64_t count = 0;
+        double sum = 0.0;
+
+        void observe(duration elapsed);
+        void write(std::ostream& out, const std::string& name, const std::string& labels) const;
+    };
+
+    metrics() = default;
+
+    std::atomic<long> active_sessions_{ 0 };
+    std::atomic<std::uint64_t> sessions_total_{ 0 };
+
+    mutable std::mutex mutex_;
+    histogram requests_;
+    histogram transactions_;
+    std::map<std::string, histogram> handlers_;
+    std::map<std::string, std::uint64_t> handler_statements_;
+    std::map<std::string, session_footprint> session_footprints_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_METRICS_HPP_
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "metrics_resource.hpp"
+
+#include <chrono>
+#include <limits>
+#include <ostream>
+
+#include "metrics.hpp"
+
+namespace
+{
+
+bool is_loopback(const std::string& address)
+{
+    return address == "::1" || address.compare(0, 4, "127.") == 0 || address.compare(0, 11, "::ffff:127.") == 0;
+}
+
+void write_metric(std::ostream& out, const char* name, const char* type, const char* help, double value)
+{
+    out << "# HELP " << name << ' ' << help << '\n'
+        << "# TYPE " << name << ' ' << type << '\n'
+        << name << ' ' << value << '\n';
+}
+
+double to_seconds(std::chrono::microseconds duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+void write_pool(std::ostream& out, const agromaster::connection_pool::statistics& stats)
+{
+    write_metric(out, "agromaster_db_pool_open_connections", "gauge",
+        "Connections currently open.", stats.open_connections);
+    write_metric(out, "agromaster_db_pool_idle_connections", "gauge",
+        "Open connections not checked out.", stats.idle_connections);
+    write_metric(out, "agromaster_db_pool_max_connections", "gauge",
+        "Upper bound of the pool.", stats.max_connections);
+    write_metric(out, "agromaster_db_pool_peak_in_use", "gauge",
+        "Most connections checked out at once.", stats.peak_in_use);
+    write_metric(out, "agromaster_db_pool_checkouts_total", "counter",
+        "Connections handed out.", static_cast<double>(stats.checkouts));
+    write_metric(out, "agromaster_db_pool_waits_total", "counter",
+        "Checkouts that found the pool saturated and had to wait.", static_cast<double>(stats.waits));
+    write_metric(out, "agromaster_db_pool_timeouts_total", "counter",
+        "Checkouts that gave up waiting.", static_cast<double>(stats.timeouts));
+    write_metric(out, "agromaster_db_pool_rejected_total", "counter",
+        "Checkouts turned away because the wait queue was full.", static_cast<double>(stats.rejected));
+    write_metric(out, "agromaster_db_pool_waiting", "gauge",
+        "Callers currently waiting for a connection.", stats.waiting);
+    write_metric(out, "agromaster_db_pool_wait_seconds_total", "counter",
+        "Time spent waiting for connections.", to_seconds(stats.total_wait));
+    write_metric(out, "agromaster_db_pool_max_wait_seconds", "gauge",
+        "Longest wait for a connection.", to_seconds(stats.max_wait));
+    write_metric(out, "agromaster_db_pool_checkout_seconds_total", "counter",
+        "Time connections spent checked out.", to_seconds(stats.total_checkout));
+}
+
+void write_climate(std::ostream& out, const agromaster::climate_writer::statistics& stats)
+{
+    write_metric(out, "agromaster_climate_appended_points_total", "counter",
+        "Climate points accepted into the buffer.", static_cast<double>(stats.appended));
+    write_metric(out, "agromaster_climate_written_points_total", "counter",
+        "Climate points written to the database.", static_cast<double>(stats.written));
+    write_metric(out, "agromaster_climate_refused_points_total", "counter",
+        "Climate points refused because the buffer was full.", static_cast<double>(stats.refused));
+    write_metric(out, "agromaster_climate_discarded_points_total", "counter",
+        "Climate points dropped after failed flushes.", static_cast<double>(stats.discarded));
+    write_metric(out, "agromaster_climate_flushes_total", "counter",
+        "Flushes of the buffer to the database.", static_cast<double>(stats.flushes));
+    write_metric(out, "agromaster_climate_failed_flushes_total", "counter",
+        "Flushes whose transaction failed.", static_cast<double>(stats.failed_flushes));
+    write_metric(out, "agromaster_climate_buffered_points", "gauge",
+        "Climate points waiting for a flush.", static_cast<double>(stats.buffered));
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+metrics_resource::metrics_resource(const connection_pool& pool, const climate_writer& climate)
+    : pool_(pool)
+    , climate_(climate)
+{
+}
+
+metrics_resource::~metrics_resource()
+{
+    beingDeleted();
+}
+
+void metrics_resource::handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+    if (!is_loopback(request.clientAddress()))
+    {
+        response.setStatus(403);
+        return;
+    }
+
+    response.setMimeType("text/plain; version=0.0.4");
+    std::ostream& out = response.out();
+    out.precision(std::numeric_limits<double>::digits10);
+    metrics::instance().write(out);
+    write_pool(out, pool_.stats());
+    write_climate(out, climate_.stats());
+}
+
+} // agromaster
\ No newline at end of file
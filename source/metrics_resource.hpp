@@ -0,0 +1,33 @@
+#pragma once
+#ifndef AGROMASTER_METRICS_RESOURCE_HPP_
+#define AGROMASTER_METRICS_RESOURCE_HPP_
+
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+#include <Wt/WResource.h>
+
+#include "climate_writer.hpp"
+#include "connection_pool.hpp"
+
+namespace agromaster
+{
+
+// Plain text scrape endpoint for the metrics registry, the connection pool and the climate
+// writer, in the Prometheus exposition format. Only answers requests from the loopback interface, where
+// the collector runs.
+class metrics_resource final : public Wt::WResource
+{
+public:
+    metrics_resource(const connection_pool& pool, const climate_writer& climate);
+    ~metrics_resource() override;
+
+    void handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+
+private:
+    const connection_pool& pool_;
+    const climate_writer& climate_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_METRICS_RESOURCE_HPP_
\ No newline at end of file
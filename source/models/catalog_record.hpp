@@ -0,0 +1,60 @@
+#pragma once
+#ifndef AGROMASTER_MODELS_CATALOG_RECORD_HPP_
+#define AGROMASTER_MODELS_CATALOG_RECORD_HPP_
+
+#include <string>
+
+#include <Wt/WDate.h>
+
+namespace agromaster
+{
+namespace models
+{
+
+// A new crop with its schedule, as inserted in bulk by session::insert_crops().
+// The date sets are encoded with encode_dates().
+struct crop_record
+{
+    std::string title;
+    Wt::WDate sowing;
+    Wt::WDate harvest;
+    std::string fertilizer_dates;
+    std::string watering_dates;
+};
+
+// A new hothouse with its works, as inserted in bulk by session::insert_hothouses().
+// crop_id is 0 for a hothouse without a crop.
+struct hothouse_record
+{
+    std::string title;
+    long long crop_id = 0;
+    double yields = 0.0;
+    double spent_fertilizers = 0.0;
+    Wt::WDate sowing;
+    Wt::WDate harvest;
+    std::string fertilizer_dates;
+    std::string watering_dates;
+};
+
+// A crop as exported, with the totals of its hothouses.
+struct crop_export
+{
+    long long id = 0;
+    crop_record crop;
+    int hothouses = 0;
+    double yields = 0.0;
+    double spent_fertilizers = 0.0;
+};
+
+// A hothouse as exported; crop_title is empty for a hothouse without a crop.
+struct hothouse_export
+{
+    long long id = 0;
+    hothouse_record hothouse;
+    std::string crop_title;
+};
+
+} // models
+} // agromaster
+
+#endif // AGROMASTER_MODELS_CATALOG_RECORD_HPP_
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef AGROMASTER_MODELS_CLIMATE_HPP_
+#define AGROMASTER_MODELS_CLIMATE_HPP_
+
+#include <cstdint>
+
+namespace agromaster
+{
+namespace models
+{
+
+// Stored as a smallint; values must never be renumbered.
+enum class climate_metric : int
+{
+    temperature = 1,
+    humidity = 2,
+    co2 = 3,
+    soil_moisture = 4,
+};
+
+// Bucket length in seconds; days are UTC days.
+enum class climate_resolution : int
+{
+    hourly = 3600,
+    daily = 86400,
+};
+
+// One sensor sample. Times are seconds since the epoch, UTC.
+struct climate_point
+{
+    long long hothouse_id = 0;
+    climate_metric metric = climate_metric::temperature;
+    std::int64_t measured_at = 0;
+    double value = 0.0;
+};
+
+// The times [from, to) of one hothouse.
+struct climate_span
+{
+    long long hothouse_id = 0;
+    std::int64_t from = 0;
+    std::int64_t to = 0;
+};
+
+// Aggregate of the samples of one metric of one hothouse in [bucket_start, bucket_start + resolution).
+struct climate_rollup
+{
+    std::int64_t bucket_start = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    long long count = 0;
+};
+
+} // models
+} // agromaster
+
+#endif // AGROMASTER_MODELS_CLIMATE_HPP_
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#ifndef AGROMASTER_MODELS_CROP_SUMMARY_HPP_
+#define AGROMASTER_MODELS_CROP_SUMMARY_HPP_
+
+#include <string>
+
+namespace agromaster
+{
+namespace models
+{
+
+// One row of the crops table: the crop together with the aggregates over its hothouses.
+struct crop_summary
+{
+    long long id = 0;
+    std::string title;
+    int hothouses_count = 0;
+    double yields = 0.0;
+    double spent_fertilizers = 0.0;
+};
+
+} // models
+} // agromaster
+
+#endif // AGROMASTER_MODELS_CROP_SUMMARY_HPP_
\ No newline at end of file
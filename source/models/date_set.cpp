@@ -0,0 +1,142 @@
+#include "date_set.hpp"
+
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+constexpr char date_format[] = "yyyy-MM-dd";
+constexpr char run_separator = ';';
+constexpr char range_separator[] = "..";
+constexpr char step_separator = '/';
+
+// Shorter runs are cheaper to write out date by date.
+constexpr std::size_t min_stepped_run = 3;
+
+void append_run(std::string& encoded, int first, int last, int step)
+{
+    if (!encoded.empty())
+    {
+        encoded += run_separator;
+    }
+    encoded += Wt::WDate::fromJulianDay(first).toString(date_format).toUTF8();
+    if (last != first)
+    {
+        encoded += range_separator;
+        encoded += Wt::WDate::fromJulianDay(last).toString(date_format).toUTF8();
+        if (step != 1)
+        {
+            encoded += step_separator;
+            encoded += std::to_string(step);
+        }
+    }
+}
+
+void decode_run(const std::string& run, std::set<Wt::WDate>& dates)
+{
+    const std::size_t range = run.find(range_separator);
+    const Wt::WDate first = Wt::WDate::fromString(run.substr(0, range), date_format);
+    if (!first.isValid())
+    {
+        return;
+    }
+    if (range == std::string::npos)
+    {
+        dates.insert(first);
+        return;
+    }
+
+    const std::size_t step_position = run.find(step_separator, range);
+    const std::size_t last_position = range + sizeof(range_separator) - 1;
+    const Wt::WDate last = Wt::WDate::fromString(
+        run.substr(last_position, step_position == std::string::npos ? std::string::npos : step_position - last_position),
+        date_format);
+    int step = 1;
+    if (step_position != std::string::npos)
+    {
+        try
+        {
+            step = std::stoi(run.substr(step_position + 1));
+        }
+        catch (const std::exception&)
+        {
+            return;
+        }
+    }
+    if (!last.isValid() || last < first || step < 1)
+    {
+        return;
+    }
+
+    auto hint = dates.end();
+    for (int day = first.toJulianDay(); day <= last.toJulianDay(); day += step)
+    {
+        hint = std::next(dates.insert(hint, Wt::WDate::fromJulianDay(day)));
+    }
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+namespace models
+{
+
+std::string encode_dates(const std::set<Wt::WDate>& dates)
+{
+    std::vector<int> days;
+    days.reserve(dates.size());
+    for (const Wt::WDate& date : dates)
+    {
+        if (date.isValid())
+        {
+            days.push_back(date.toJulianDay());
+        }
+    }
+
+    std::string encoded;
+    std::size_t i = 0;
+    while (i < days.size())
+    {
+        std::size_t end = i + 1;
+        if (end < days.size())
+        {
+            const int step = days[end] - days[i];
+            while (end < days.size() && days[end] - days[end - 1] == step)
+            {
+                ++end;
+            }
+            if (step == 1 || end - i >= min_stepped_run)
+            {
+                append_run(encoded, days[i], days[end - 1], step);
+                i = end;
+                continue;
+            }
+        }
+        append_run(encoded, days[i], days[i], 1);
+        ++i;
+    }
+    return encoded;
+}
+
+std::set<Wt::WDate> decode_dates(const std::string& encoded)
+{
+    std::set<Wt::WDate> dates;
+    std::size_t begin = 0;
+    while (begin < encoded.size())
+    {
+        std::size_t end = encoded.find(run_separator, begin);
+        if (end == std::string::npos)
+        {
+            end = encoded.size();
+        }
+        decode_run(encoded.substr(begin, end - begin), dates);
+        begin = end + 1;
+    }
+    return dates;
+}
+
+} // models
+} // agromaster
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#ifndef AGROMASTER_MODELS_DATE_SET_HPP_
+#define AGROMASTER_MODELS_DATE_SET_HPP_
+
+#include <set>
+#include <string>
+
+#include <Wt/WDate.h>
+
+namespace agromaster
+{
+namespace models
+{
+
+// Date sets of works and schedules are stored in one text column as runs of evenly spaced
+// dates: "2024-05-01..2024-09-30;2024-10-03;2024-10-10..2024-11-07/7". A run without a
+// step is daily, a run with "/n" repeats every n days. A season of daily watering is one run.
+std::string encode_dates(const std::set<Wt::WDate>& dates);
+// Invalid runs are skipped.
+std::set<Wt::WDate> decode_dates(const std::string& encoded);
+
+} // models
+} // agromaster
+
+#endif // AGROMASTER_MODELS_DATE_SET_HPP_
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#ifndef AGROMASTER_MODELS_HOTHOUSE_READING_HPP_
+#define AGROMASTER_MODELS_HOTHOUSE_READING_HPP_
+
+#include <string>
+
+namespace agromaster
+{
+namespace models
+{
+
+// Quantities reported for one hothouse by a weighing station or a dosing controller;
+// they are added to the hothouse totals.
+struct hothouse_reading
+{
+    std::string hothouse;
+    double yields = 0.0;
+    double spent_fertilizers = 0.0;
+};
+
+} // models
+} // agromaster
+
+#endif // AGROMASTER_MODELS_HOTHOUSE_READING_HPP_
\ No newline at end of file
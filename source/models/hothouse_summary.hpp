@@ -0,0 +1,26 @@
+#pragma once
+#ifndef AGROMASTER_MODELS_HOTHOUSE_SUMMARY_HPP_
+#define AGROMASTER_MODELS_HOTHOUSE_SUMMARY_HPP_
+
+#include <string>
+
+namespace agromaster
+{
+namespace models
+{
+
+// One row of the hothouses table, read without materializing the hothouse and its crop.
+struct hothouse_summary
+{
+    long long id = 0;
+    std::string title;
+    long long crop_id = 0;
+    std::string crop_title;
+    double yields = 0.0;
+    double spent_fertilizers = 0.0;
+};
+
+} // models
+} // agromaster
+
+#endif // AGROMASTER_MODELS_HOTHOUSE_SUMMARY_HPP_
\ No newline at end of file
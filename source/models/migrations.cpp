@@ -0,0 +1,248 @@
+#include "migrations.hpp"
+
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+
+#include <Wt/Auth/Identity.h>
+#include <Wt/Auth/PasswordService.h>
+#include <Wt/WLogger.h>
+
+namespace
+{
+
+using agromaster::models::session;
+
+// What the migrations need to know about the database, probed before any of them runs:
+// a failed probe statement inside a migration's transaction would abort it on Postgres.
+struct database_facts
+{
+    bool postgres;
+    // Dates still live in the one-row-per-date tables of schema version 1.
+    bool date_tables;
+};
+
+// apply runs inside the transaction that records the new version.
+struct migration
+{
+    int version;
+    const char* description;
+    void (*apply)(session&, const database_facts&);
+};
+
+// Schema version produced by session::createTables() for the current mapping.
+constexpr int created_schema_version = 2;
+
+// Schema of databases created before schema_version was introduced.
+constexpr int initial_schema_version = 1;
+
+void create_admin(session& session)
+{
+    Wt::Auth::User admin = session.users().registerNew();
+    admin.addIdentity(Wt::Auth::Identity::LoginName, "admin");
+    session.users().setPassword(admin, session::password_auth().verifier()->hashPassword("admin"));
+
+    Wt::Dbo::ptr<agromaster::models::AuthInfo> auth_info = session.users().find(admin);
+    auth_info.modify()->setUser(session.add(
+        std::make_unique<agromaster::models::user_account>(agromaster::models::user_account::role::admin)));
+}
+
+// Probes run in a transaction of their own: a failed statement aborts the whole
+// transaction on Postgres.
+bool has_table(session& session, const std::string& table)
+{
+    try
+    {
+        Wt::Dbo::Transaction transaction(session);
+        session.query<int>("select count(1) from " + table).resultValue();
+        return true;
+    }
+    catch (const Wt::Dbo::Exception&)
+    {
+        return false;
+    }
+}
+
+bool is_postgres(session& session)
+{
+    try
+    {
+        Wt::Dbo::Transaction transaction(session);
+        return session.query<std::string>("select version()").resultValue().compare(0, 10, "PostgreSQL") == 0;
+    }
+    catch (const Wt::Dbo::Exception&)
+    {
+        return false;
+    }
+}
+
+using date_row = std::tuple<long long, Wt::WDate>;
+
+// Moves the one-row-per-date table of an old database into the encoded column of its owner.
+void pack_dates(session& session, const std::string& table, const std::string& owner, const std::string& column)
+{
+    std::map<long long, std::set<Wt::WDate>> dates;
+    Wt::Dbo::collection<date_row> rows = session.query<date_row>("select " + owner + "_id, \"date\" from " + table);
+    for (const date_row& row : rows)
+    {
+        dates[std::get<0>(row)].insert(std::get<1>(row));
+    }
+
+    for (const auto& owner_dates : dates)
+    {
+        session.execute("update " + owner + " set " + column + " = ? where id = ?")
+            .bind(agromaster::models::encode_dates(owner_dates.second))
+            .bind(owner_dates.first)
+            .run();
+    }
+    session.execute("drop table " + table);
+}
+
+void store_dates_in_columns(session& session, const database_facts& facts)
+{
+    // Databases created by createTables() between this change and schema_version
+    // already have the columns.
+    if (!facts.date_tables)
+    {
+        return;
+    }
+
+    for (const std::string owner : { "works", "schedules" })
+    {
+        session.execute("alter table " + owner + " add column fertilizer_dates text not null default ''");
+        session.execute("alter table " + owner + " add column watering_dates text not null default ''");
+    }
+    pack_dates(session, "fertilizer_works", "works", "fertilizer_dates");
+    pack_dates(session, "watering_works", "works", "watering_dates");
+    pack_dates(session, "fertilizer_schedules", "schedules", "fertilizer_dates");
+    pack_dates(session, "watering_schedules", "schedules", "watering_dates");
+}
+
+void create_lookup_indexes(session& session, const database_facts&)
+{
+    session.execute("create unique index if not exists crop_title_idx on crop (title)");
+    session.execute("create unique index if not exists hothouse_title_idx on hothouse (title)");
+    // Remember-me logins look tokens up by value, password logins identities by name.
+    session.execute("create index if not exists auth_token_value_idx on auth_token (value)");
+    session.execute("create index if not exists auth_identity_lookup_idx on auth_identity (provider, identity)");
+}
+
+void create_climate_tables(session& session, const database_facts& facts)
+{
+    // Postgres stores the raw points in monthly partitions created by climate_writer, so old
+    // months can be detached or dropped whole; other backends get a plain table.
+    const std::string partitioning = facts.postgres ? " partition by range (measured_at)" : "";
+
+    session.execute(
+        "create table if not exists climate_reading ("
+        "hothouse_id bigint not null references hothouse (id) on delete cascade, "
+        "metric smallint not null, "
+        "measured_at bigint not null, "
+        "value double precision not null, "
+        "primary key (hothouse_id, metric, measured_at))" + partitioning);
+    session.execute(
+        "create table if not exists climate_rollup ("
+        "hothouse_id bigint not null references hothouse (id) on delete cascade, "
+        "metric smallint not null, "
+        "resolution integer not null, "
+        "bucket_start bigint not null, "
+        "min_value double precision not null, "
+        "max_value double precision not null, "
+        "sum_value double precision not null, "
+        "value_count bigint not null, "
+        "primary key (hothouse_id, metric, resolution, bucket_start))");
+}
+
+// Ordered by version. Migrations up to created_schema_version must cope with databases that
+// createTables() made after the change they describe; later ones only ever see older schemas.
+const migration migrations[] =
+{
+    { 2, "store fertilizer and watering dates in works and schedules", store_dates_in_columns },
+    { 3, "unique title indexes and auth lookup indexes", create_lookup_indexes },
+    { 4, "climate readings and their hourly and daily rollups", create_climate_tables },
+};
+
+// -1 when the database has no schema_version table yet.
+int stored_version(session& session)
+{
+    try
+    {
+        Wt::Dbo::Transaction transaction(session);
+        return session.query<int>("select version from schema_version").resultValue();
+    }
+    catch (const Wt::Dbo::Exception&)
+    {
+        return -1;
+    }
+}
+
+int create_version_table(session& session)
+{
+    const bool existing_database = has_table(session, "crop");
+
+    Wt::Dbo::Transaction transaction(session);
+    int version = initial_schema_version;
+    if (!existing_database)
+    {
+        session.createTables();
+        create_admin(session);
+        version = created_schema_version;
+        Wt::log("notice") << "migrations: created database";
+    }
+    session.execute("create table schema_version (version integer not null)");
+    session.execute("insert into schema_version (version) values (?)").bind(version).run();
+    return version;
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+namespace models
+{
+
+int latest_schema_version()
+{
+    return std::end(migrations)[-1].version;
+}
+
+void migrate(session& session)
+{
+    int version = stored_version(session);
+    if (version == latest_schema_version())
+    {
+        return;
+    }
+    if (version > latest_schema_version())
+    {
+        Wt::log("warning")
+            << "migrations: database schema version " << version
+            << " is newer than " << latest_schema_version() << " expected by this build";
+        return;
+    }
+    if (version < 0)
+    {
+        version = create_version_table(session);
+    }
+
+    const database_facts facts{ is_postgres(session), has_table(session, "fertilizer_works") };
+    for (const migration& step : migrations)
+    {
+        if (step.version <= version)
+        {
+            continue;
+        }
+
+        Wt::log("notice") << "migrations: " << step.version << ", " << step.description;
+        Wt::Dbo::Transaction transaction(session);
+        step.apply(session, facts);
+        session.execute("update schema_version set version = ?").bind(step.version).run();
+        transaction.commit();
+        version = step.version;
+    }
+}
+
+} // models
+} // agromaster
\ No newline at end of file
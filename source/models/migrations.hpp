@@ -0,0 +1,28 @@
+#pragma once
+#ifndef AGROMASTER_MODELS_MIGRATIONS_HPP_
+#define AGROMASTER_MODELS_MIGRATIONS_HPP_
+
+#include "session.hpp"
+
+namespace agromaster
+{
+namespace models
+{
+
+// Version of the schema this build expects.
+int latest_schema_version();
+
+// Brings the database up to latest_schema_version().
+//
+// The schema version lives in the one-row schema_version table, so an up to date database
+// costs a single select. A new database is created with session::createTables() plus the
+// admin account and skips the migrations that createTables() already covers; a database
+// created before schema_version existed is taken as version 1. Each migration commits in
+// one transaction with its version bump, so a failed start resumes where it stopped.
+// Throws Wt::Dbo::Exception when a migration fails.
+void migrate(session& session);
+
+} // models
+} // agromaster
+
+#endif // AGROMASTER_MODELS_MIGRATIONS_HPP_
\ No newline at end of file
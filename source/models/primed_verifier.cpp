@@ -0,0 +1,63 @@
+#include "primed_verifier.hpp"
+
+namespace
+{
+
+thread_local const agromaster::models::primed_verifier::results* current_results = nullptr;
+
+} // unnamed namespace
+
+namespace agromaster
+{
+namespace models
+{
+
+primed_verifier::scope::scope(const results& primed)
+    : previous_(current_results)
+{
+    current_results = &primed;
+}
+
+primed_verifier::scope::~scope()
+{
+    current_results = previous_;
+}
+
+primed_verifier::primed_verifier(std::unique_ptr<Wt::Auth::PasswordService::AbstractVerifier> verifier)
+    : verifier_(std::move(verifier))
+{
+}
+
+bool primed_verifier::needsUpdate(const Wt::Auth::PasswordHash& hash) const
+{
+    return verifier_->needsUpdate(hash);
+}
+
+Wt::Auth::PasswordHash primed_verifier::hashPassword(const Wt::WString& password) const
+{
+    if (current_results)
+    {
+        const auto primed = current_results->hashes.find(password.toUTF8());
+        if (primed != current_results->hashes.end())
+        {
+            return primed->second;
+        }
+    }
+    return verifier_->hashPassword(password);
+}
+
+bool primed_verifier::verify(const Wt::WString& password, const Wt::Auth::PasswordHash& hash) const
+{
+    if (current_results)
+    {
+        const auto primed = current_results->verifications.find(std::make_pair(password.toUTF8(), hash.value()));
+        if (primed != current_results->verifications.end())
+        {
+            return primed->second;
+        }
+    }
+    return verifier_->verify(password, hash);
+}
+
+} // models
+} // agromaster
\ No newline at end of file
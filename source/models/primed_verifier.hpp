@@ -0,0 +1,61 @@
+#pragma once
+#ifndef AGROMASTER_MODELS_PRIMED_VERIFIER_HPP_
+#define AGROMASTER_MODELS_PRIMED_VERIFIER_HPP_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <Wt/Auth/PasswordService.h>
+
+namespace agromaster
+{
+namespace models
+{
+
+// Password verifier that can answer from results computed ahead of time.
+//
+// Wt's registration and password update code hashes and verifies inline on the request
+// thread. The auth widgets run the verifier on the password workers first, then replay
+// that code inside a scope holding the results; within the scope hashPassword and verify
+// answer from them and only fall back to the wrapped verifier when nothing matches.
+class primed_verifier final : public Wt::Auth::PasswordService::AbstractVerifier
+{
+public:
+    struct results
+    {
+        // By password.
+        std::map<std::string, Wt::Auth::PasswordHash> hashes;
+        // By password and hash value.
+        std::map<std::pair<std::string, std::string>, bool> verifications;
+    };
+
+    // Makes results visible to every primed_verifier on the current thread.
+    class scope
+    {
+    public:
+        explicit scope(const results& primed);
+        ~scope();
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        const results* const previous_;
+    };
+
+    explicit primed_verifier(std::unique_ptr<Wt::Auth::PasswordService::AbstractVerifier> verifier);
+
+    bool needsUpdate(const Wt::Auth::PasswordHash& hash) const override;
+    Wt::Auth::PasswordHash hashPassword(const Wt::WString& password) const override;
+    bool verify(const Wt::WString& password, const Wt::Auth::PasswordHash& hash) const override;
+
+private:
+    const std::unique_ptr<Wt::Auth::PasswordService::AbstractVerifier> verifier_;
+};
+
+} // models
+} // agromaster
+
+#endif // AGROMASTER_MODELS_PRIMED_VERIFIER_HPP_
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef AGROMASTER_MODELS_SEASON_DATES_HPP_
+#define AGROMASTER_MODELS_SEASON_DATES_HPP_
+
+#include <set>
+
+#include <Wt/WDate.h>
+
+namespace agromaster
+{
+namespace models
+{
+
+// The works of a hothouse or the schedules of a crop, with their date sets decoded.
+struct season_dates
+{
+    Wt::WDate sowing;
+    Wt::WDate harvest;
+    std::set<Wt::WDate> fertilizer_dates;
+    std::set<Wt::WDate> watering_dates;
+};
+
+} // models
+} // agromaster
+
+#endif // AGROMASTER_MODELS_SEASON_DATES_HPP_
\ No newline at end of file
@@ -1,18 +1,188 @@
 #include "session.hpp"
 
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+
 #include <Wt/Auth/AuthService.h>
 #include <Wt/Auth/HashFunction.h>
+#include <Wt/Auth/Identity.h>
 #include <Wt/Auth/PasswordService.h>
 #include <Wt/Auth/PasswordVerifier.h>
 #include <Wt/Auth/PasswordStrengthValidator.h>
 #include <Wt/Auth/Dbo/AuthInfo.h>
 
+#include "primed_verifier.hpp"
+
 namespace
 {
 
 Wt::Auth::AuthService auth_service;
 Wt::Auth::PasswordService password_service(auth_service);
 
+using crop_row = std::tuple<long long, std::string, int, double, double>;
+
+constexpr char crop_rows_sql[] =
+    "select c.id, c.title, count(h.id), coalesce(sum(h.yields), 0), coalesce(sum(h.spent_fertilizers), 0) "
+    "from crop c left join hothouse h on h.crop_id = c.id";
+
+using hothouse_row = std::tuple<long long, std::string, long long, std::string, double, double>;
+
+constexpr char hothouse_rows_sql[] =
+    "select h.id, h.title, coalesce(h.crop_id, 0), coalesce(c.title, ''), h.yields, h.spent_fertilizers "
+    "from hothouse h left join crop c on c.id = h.crop_id";
+
+using season_row = std::tuple<Wt::WDate, Wt::WDate, std::string, std::string>;
+
+constexpr char works_row_sql[] =
+    "select sowing_work, harvest_work, coalesce(fertilizer_dates, ''), coalesce(watering_dates, '') from works";
+
+constexpr char schedules_row_sql[] =
+    "select sowing_schedule, harvest_schedule, coalesce(fertilizer_dates, ''), coalesce(watering_dates, '') "
+    "from schedules";
+
+bool to_season_dates(const Wt::Dbo::collection<season_row>& rows, agromaster::models::season_dates& dates)
+{
+    auto row = rows.begin();
+    if (row == rows.end())
+    {
+        return false;
+    }
+
+    dates.sowing = std::get<0>(*row);
+    dates.harvest = std::get<1>(*row);
+    dates.fertilizer_dates = agromaster::models::decode_dates(std::get<2>(*row));
+    dates.watering_dates = agromaster::models::decode_dates(std::get<3>(*row));
+    return true;
+}
+
+// Titles looked up per "in (...)" query, well below the bind parameter limits of the backends.
+constexpr std::size_t lookup_chunk = 500;
+
+using crop_export_row =
+    std::tuple<long long, std::string, int, double, double, Wt::WDate, Wt::WDate, std::string, std::string>;
+
+constexpr char crop_export_rows_sql[] =
+    "select c.id, c.title, count(h.id), coalesce(sum(h.yields), 0), coalesce(sum(h.spent_fertilizers), 0), "
+    "s.sowing_schedule, s.harvest_schedule, coalesce(s.fertilizer_dates, ''), coalesce(s.watering_dates, '') "
+    "from crop c left join schedules s on s.crop_id = c.id left join hothouse h on h.crop_id = c.id";
+
+using hothouse_export_row =
+    std::tuple<long long, std::string, std::string, double, double, Wt::WDate, Wt::WDate, std::string, std::string>;
+
+constexpr char hothouse_export_rows_sql[] =
+    "select h.id, h.title, coalesce(c.title, ''), h.yields, h.spent_fertilizers, "
+    "w.sowing_work, w.harvest_work, coalesce(w.fertilizer_dates, ''), coalesce(w.watering_dates, '') "
+    "from hothouse h left join crop c on c.id = h.crop_id left join works w on w.hothouse_id = h.id";
+
+// Rows per multi-row insert of crops and hothouses, at most six bind parameters each, so a
+// statement stays below the 999 parameters of older SQLite builds.
+constexpr std::size_t catalog_insert_rows = 150;
+
+// Bind markers of rows rows of one multi-row insert, each row being row_markers.
+std::string values_list(std::size_t rows, const std::string& row_markers)
+{
+    std::string list;
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        list += i == 0 ? row_markers : ", " + row_markers;
+    }
+    return list;
+}
+
+// Rows per multi-row insert of climate points, four bind parameters each.
+constexpr std::size_t climate_insert_rows = 200;
+
+using climate_rollup_row = std::tuple<long long, double, double, double, long long>;
+
+std::int64_t bucket_floor(std::int64_t time, agromaster::models::climate_resolution resolution)
+{
+    const std::int64_t length = static_cast<std::int64_t>(resolution);
+    return time - ((time % length) + length) % length;
+}
+
+// The spans widened to whole buckets, overlapping and adjacent ones of a hothouse merged.
+std::vector<agromaster::models::climate_span> bucket_spans(
+    const std::vector<agromaster::models::climate_span>& spans,
+    agromaster::models::climate_resolution resolution)
+{
+    const std::int64_t length = static_cast<std::int64_t>(resolution);
+    std::vector<agromaster::models::climate_span> buckets;
+    for (const agromaster::models::climate_span& span : spans)
+    {
+        agromaster::models::climate_span bucket = span;
+        bucket.from = bucket_floor(span.from, resolution);
+        bucket.to = bucket_floor(span.to - 1, resolution) + length;
+        if (!buckets.empty() && buckets.back().hothouse_id == bucket.hothouse_id && buckets.back().to >= bucket.from)
+        {
+            buckets.back().to = std::max(buckets.back().to, bucket.to);
+        }
+        else
+        {
+            buckets.push_back(bucket);
+        }
+    }
+    return buckets;
+}
+
+// "(hothouse_id = ? and column >= ? and column < ?) or ..." for count spans, parenthesized.
+std::string span_conditions(std::size_t count, const std::string& column)
+{
+    const std::string condition = "(hothouse_id = ? and " + column + " >= ? and " + column + " < ?)";
+    std::string conditions;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        conditions += i == 0 ? condition : " or " + condition;
+    }
+    return "(" + conditions + ")";
+}
+
+void bind_spans(Wt::Dbo::Call& call, const std::vector<agromaster::models::climate_span>& spans)
+{
+    for (const agromaster::models::climate_span& span : spans)
+    {
+        call.bind(span.hothouse_id).bind(static_cast<long long>(span.from)).bind(static_cast<long long>(span.to));
+    }
+}
+
+// Comma separated list of count bind markers for an "in (...)" clause.
+std::string placeholders(std::size_t count)
+{
+    std::string list;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        list += i == 0 ? "?" : ", ?";
+    }
+    return list;
+}
+
+std::vector<agromaster::models::crop_summary> to_crop_summaries(const Wt::Dbo::collection<crop_row>& rows)
+{
+    std::vector<agromaster::models::crop_summary> summaries;
+    for (const crop_row& row : rows)
+    {
+        agromaster::models::crop_summary summary;
+        std::tie(summary.id, summary.title, summary.hothouses_count, summary.yields, summary.spent_fertilizers) = row;
+        summaries.push_back(std::move(summary));
+    }
+    return summaries;
+}
+
+std::vector<agromaster::models::hothouse_summary> to_hothouse_summaries(
+    const Wt::Dbo::collection<hothouse_row>& rows)
+{
+    std::vector<agromaster::models::hothouse_summary> summaries;
+    for (const hothouse_row& row : rows)
+    {
+        agromaster::models::hothouse_summary summary;
+        std::tie(summary.id, summary.title, summary.crop_id, summary.crop_title,
+            summary.yields, summary.spent_fertilizers) = row;
+        summaries.push_back(std::move(summary));
+    }
+    return summaries;
+}
+
 } // unnamed namespace
 
 namespace agromaster
@@ -20,23 +190,445 @@ namespace agromaster
 namespace models
 {
 
-Wt::Dbo::ptr<models::user_account> session::user() const
+Wt::Dbo::ptr<models::user_account> session::user()
 {
-    if (login_.loggedIn()) {
+    resolve_user();
+    return user_;
+}
+
+enum user_account::role session::user_role()
+{
+    resolve_user();
+    return user_ ? user_->role : user_account::role::visitor;
+}
+
+const Wt::WString& session::login_name()
+{
+    resolve_user();
+    return login_name_;
+}
+
+void session::resolve_user()
+{
+    if (user_resolved_)
+    {
+        return;
+    }
+
+    Wt::Dbo::ptr<user_account> account;
+    Wt::WString login_name;
+    if (login_.loggedIn())
+    {
         Wt::Dbo::ptr<AuthInfo> auth_info = users_->find(login_.user());
-        return auth_info->user();
+        account = auth_info->user();
+        if (!account)
+        {
+            account = add(std::make_unique<user_account>(user_account::role::visitor));
+            auth_info.modify()->setUser(account);
+        }
+        login_name = login_.user().identity(Wt::Auth::Identity::LoginName);
     }
-    else
+
+    user_ = account;
+    login_name_ = login_name;
+    user_resolved_ = true;
+}
+
+std::vector<crop_summary> session::crop_summaries()
+{
+    return to_crop_summaries(query<crop_row>(crop_rows_sql)
+        .groupBy("c.id, c.title")
+        .orderBy("c.id"));
+}
+
+std::vector<hothouse_summary> session::hothouse_summaries_after(long long after_id, int limit)
+{
+    return to_hothouse_summaries(query<hothouse_row>(hothouse_rows_sql)
+        .where("h.id > ?").bind(after_id)
+        .orderBy("h.id")
+        .limit(limit));
+}
+
+std::vector<hothouse_summary> session::hothouse_summaries_from(int offset, int limit)
+{
+    return to_hothouse_summaries(query<hothouse_row>(hothouse_rows_sql)
+        .orderBy("h.id")
+        .offset(offset)
+        .limit(limit));
+}
+
+std::vector<hothouse_summary> session::hothouse_summaries(const std::set<long long>& ids)
+{
+    if (ids.empty())
+    {
+        return std::vector<hothouse_summary>();
+    }
+
+    Wt::Dbo::Query<hothouse_row> hothouses =
+        query<hothouse_row>(hothouse_rows_sql).where("h.id in (" + placeholders(ids.size()) + ")");
+    for (long long id : ids)
+    {
+        hothouses.bind(id);
+    }
+    return to_hothouse_summaries(hothouses.orderBy("h.id"));
+}
+
+int session::hothouses_count()
+{
+    return query<int>("select count(1) from hothouse").resultValue();
+}
+
+std::vector<std::string> session::add_hothouse_readings(
+    const std::vector<hothouse_reading>& readings,
+    std::set<long long>& hothouse_ids,
+    std::set<long long>& crop_ids)
+{
+    // Hothouse and crop id by title, resolved in one query per lookup_chunk titles.
+    std::map<std::string, std::pair<long long, long long>> targets;
+    for (std::size_t first = 0; first < readings.size(); first += lookup_chunk)
+    {
+        const std::size_t count = std::min(lookup_chunk, readings.size() - first);
+        Wt::Dbo::Query<std::tuple<long long, std::string, long long>> hothouses =
+            query<std::tuple<long long, std::string, long long>>("select id, title, coalesce(crop_id, 0) from hothouse")
+                .where("title in (" + placeholders(count) + ")");
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+            hothouses.bind(readings[i].hothouse);
+        }
+        for (const auto& row : hothouses.resultList())
+        {
+            targets[std::get<1>(row)] = std::make_pair(std::get<0>(row), std::get<2>(row));
+        }
+    }
+
+    std::vector<std::string> unknown;
+    for (const hothouse_reading& reading : readings)
+    {
+        auto target = targets.find(reading.hothouse);
+        if (target == targets.end())
+        {
+            unknown.push_back(reading.hothouse);
+            continue;
+        }
+        // Bumping the version makes sessions holding the row notice the change on save.
+        execute("update hothouse set yields = yields + ?, spent_fertilizers = spent_fertilizers + ?, "
+            "version = version + 1 where id = ?")
+            .bind(reading.yields)
+            .bind(reading.spent_fertilizers)
+            .bind(target->second.first)
+            .run();
+        hothouse_ids.insert(target->second.first);
+        if (target->second.second > 0)
+        {
+            crop_ids.insert(target->second.second);
+        }
+    }
+    return unknown;
+}
+
+bool session::hothouse_works(long long hothouse_id, season_dates& works)
+{
+    return to_season_dates(
+        query<season_row>(works_row_sql).where("hothouse_id = ?").bind(hothouse_id).limit(1),
+        works);
+}
+
+bool session::crop_schedules(long long crop_id, season_dates& schedules)
+{
+    return to_season_dates(
+        query<season_row>(schedules_row_sql).where("crop_id = ?").bind(crop_id).limit(1),
+        schedules);
+}
+
+std::vector<crop_export> session::crop_exports_after(long long after_id, int limit)
+{
+    Wt::Dbo::collection<crop_export_row> rows = query<crop_export_row>(crop_export_rows_sql)
+        .where("c.id > ?").bind(after_id)
+        .groupBy("c.id, c.title, s.sowing_schedule, s.harvest_schedule, s.fertilizer_dates, s.watering_dates")
+        .orderBy("c.id")
+        .limit(limit);
+
+    std::vector<crop_export> crops;
+    for (const crop_export_row& row : rows)
+    {
+        crop_export crop;
+        crop.id = std::get<0>(row);
+        crop.crop.title = std::get<1>(row);
+        crop.hothouses = std::get<2>(row);
+        crop.yields = std::get<3>(row);
+        crop.spent_fertilizers = std::get<4>(row);
+        crop.crop.sowing = std::get<5>(row);
+        crop.crop.harvest = std::get<6>(row);
+        crop.crop.fertilizer_dates = std::get<7>(row);
+        crop.crop.watering_dates = std::get<8>(row);
+        crops.push_back(std::move(crop));
+    }
+    return crops;
+}
+
+std::vector<hothouse_export> session::hothouse_exports_after(long long after_id, int limit)
+{
+    Wt::Dbo::collection<hothouse_export_row> rows = query<hothouse_export_row>(hothouse_export_rows_sql)
+        .where("h.id > ?").bind(after_id)
+        .orderBy("h.id")
+        .limit(limit);
+
+    std::vector<hothouse_export> hothouses;
+    for (const hothouse_export_row& row : rows)
+    {
+        hothouse_export hothouse;
+        hothouse.id = std::get<0>(row);
+        hothouse.hothouse.title = std::get<1>(row);
+        hothouse.crop_title = std::get<2>(row);
+        hothouse.hothouse.yields = std::get<3>(row);
+        hothouse.hothouse.spent_fertilizers = std::get<4>(row);
+        hothouse.hothouse.sowing = std::get<5>(row);
+        hothouse.hothouse.harvest = std::get<6>(row);
+        hothouse.hothouse.fertilizer_dates = std::get<7>(row);
+        hothouse.hothouse.watering_dates = std::get<8>(row);
+        hothouses.push_back(std::move(hothouse));
+    }
+    return hothouses;
+}
+
+std::map<std::string, long long> session::crop_ids_by_title()
+{
+    std::map<std::string, long long> ids;
+    for (const auto& row : query<std::tuple<long long, std::string>>("select id, title from crop").resultList())
+    {
+        ids.emplace(std::get<1>(row), std::get<0>(row));
+    }
+    return ids;
+}
+
+std::map<std::string, long long> session::hothouse_ids_by_title(const std::vector<std::string>& titles)
+{
+    std::map<std::string, long long> ids;
+    for (std::size_t first = 0; first < titles.size(); first += lookup_chunk)
+    {
+        const std::size_t count = std::min(lookup_chunk, titles.size() - first);
+        Wt::Dbo::Query<std::tuple<long long, std::string>> hothouses =
+            query<std::tuple<long long, std::string>>("select id, title from hothouse")
+                .where("title in (" + placeholders(count) + ")");
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+            hothouses.bind(titles[i]);
+        }
+        for (const auto& row : hothouses.resultList())
+        {
+            ids.emplace(std::get<1>(row), std::get<0>(row));
+        }
+    }
+    return ids;
+}
+
+std::map<std::string, long long> session::insert_crops(const std::vector<crop_record>& crops)
+{
+    std::map<std::string, long long> ids;
+    for (std::size_t first = 0; first < crops.size(); first += catalog_insert_rows)
+    {
+        const std::size_t count = std::min(catalog_insert_rows, crops.size() - first);
+        Wt::Dbo::Call insert = execute("insert into crop (version, title) values " + values_list(count, "(0, ?)"));
+        Wt::Dbo::Query<std::tuple<long long, std::string>> inserted =
+            query<std::tuple<long long, std::string>>("select id, title from crop")
+                .where("title in (" + placeholders(count) + ")");
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+            insert.bind(crops[i].title);
+            inserted.bind(crops[i].title);
+        }
+        insert.run();
+
+        std::map<std::string, long long> chunk_ids;
+        for (const auto& row : inserted.resultList())
+        {
+            chunk_ids.emplace(std::get<1>(row), std::get<0>(row));
+        }
+
+        Wt::Dbo::Call insert_schedules = execute(
+            "insert into schedules (version, sowing_schedule, harvest_schedule, fertilizer_dates, watering_dates, crop_id) "
+            "values " + values_list(count, "(0, ?, ?, ?, ?, ?)"));
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+            insert_schedules.bind(crops[i].sowing).bind(crops[i].harvest)
+                .bind(crops[i].fertilizer_dates).bind(crops[i].watering_dates)
+                .bind(chunk_ids.at(crops[i].title));
+        }
+        insert_schedules.run();
+        ids.insert(chunk_ids.begin(), chunk_ids.end());
+    }
+    return ids;
+}
+
+std::map<std::string, long long> session::insert_hothouses(const std::vector<hothouse_record>& hothouses)
+{
+    std::map<std::string, long long> ids;
+    for (std::size_t first = 0; first < hothouses.size(); first += catalog_insert_rows)
+    {
+        const std::size_t count = std::min(catalog_insert_rows, hothouses.size() - first);
+        Wt::Dbo::Call insert = execute(
+            "insert into hothouse (version, title, yields, spent_fertilizers, crop_id) values "
+            + values_list(count, "(0, ?, ?, ?, nullif(?, 0))"));
+        std::vector<std::string> titles;
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+            insert.bind(hothouses[i].title).bind(hothouses[i].yields).bind(hothouses[i].spent_fertilizers)
+                .bind(hothouses[i].crop_id);
+            titles.push_back(hothouses[i].title);
+        }
+        insert.run();
+
+        const std::map<std::string, long long> chunk_ids = hothouse_ids_by_title(titles);
+        Wt::Dbo::Call insert_works = execute(
+            "insert into works (version, sowing_work, harvest_work, fertilizer_dates, watering_dates, hothouse_id) "
+            "values " + values_list(count, "(0, ?, ?, ?, ?, ?)"));
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+            insert_works.bind(hothouses[i].sowing).bind(hothouses[i].harvest)
+                .bind(hothouses[i].fertilizer_dates).bind(hothouses[i].watering_dates)
+                .bind(chunk_ids.at(hothouses[i].title));
+        }
+        insert_works.run();
+        ids.insert(chunk_ids.begin(), chunk_ids.end());
+    }
+    return ids;
+}
+
+std::set<long long> session::existing_hothouses(const std::set<long long>& ids)
+{
+    std::set<long long> existing;
+    std::vector<long long> pending(ids.begin(), ids.end());
+    for (std::size_t first = 0; first < pending.size(); first += lookup_chunk)
+    {
+        const std::size_t count = std::min(lookup_chunk, pending.size() - first);
+        Wt::Dbo::Query<long long> hothouses =
+            query<long long>("select id from hothouse").where("id in (" + placeholders(count) + ")");
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+            hothouses.bind(pending[i]);
+        }
+        for (long long id : hothouses.resultList())
+        {
+            existing.insert(id);
+        }
+    }
+    return existing;
+}
+
+bool session::climate_readings_partitioned()
+{
+    return query<int>(
+        "select count(1) from pg_partitioned_table p join pg_class c on c.oid = p.partrelid "
+        "where c.relname = 'climate_reading'").resultValue() > 0;
+}
+
+void session::create_climate_partition(const std::string& name, std::int64_t from, std::int64_t to)
+{
+    execute(
+        "create table if not exists " + name + " partition of climate_reading "
+        "for values from (" + std::to_string(from) + ") to (" + std::to_string(to) + ")");
+}
+
+void session::append_climate_points(const std::vector<climate_point>& points)
+{
+    for (std::size_t first = 0; first < points.size(); first += climate_insert_rows)
+    {
+        const std::size_t count = std::min(climate_insert_rows, points.size() - first);
+        std::string sql = "insert into climate_reading (hothouse_id, metric, measured_at, value) values ";
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            sql += i == 0 ? "(?, ?, ?, ?)" : ", (?, ?, ?, ?)";
+        }
+        sql += " on conflict do nothing";
+
+        Wt::Dbo::Call insert = execute(sql);
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+            insert.bind(points[i].hothouse_id)
+                .bind(static_cast<int>(points[i].metric))
+                .bind(static_cast<long long>(points[i].measured_at))
+                .bind(points[i].value);
+        }
+        insert.run();
+    }
+}
+
+void session::refresh_climate_rollups(const std::vector<climate_span>& spans)
+{
+    if (spans.empty())
+    {
+        return;
+    }
+
+    const long long hour = static_cast<long long>(climate_resolution::hourly);
+    const long long day = static_cast<long long>(climate_resolution::daily);
+    const std::vector<climate_span> hours = bucket_spans(spans, climate_resolution::hourly);
+    // Whole days, so a day touched at its end still covers its earlier hours.
+    const std::vector<climate_span> days = bucket_spans(spans, climate_resolution::daily);
+    const std::string upsert =
+        " on conflict (hothouse_id, metric, resolution, bucket_start) do update set "
+        "min_value = excluded.min_value, max_value = excluded.max_value, "
+        "sum_value = excluded.sum_value, value_count = excluded.value_count";
+    // The bucket lengths are spelled out: a grouped expression may not contain bind markers.
+    const std::string hour_bucket = "measured_at - measured_at % " + std::to_string(hour);
+    const std::string day_bucket = "bucket_start - bucket_start % " + std::to_string(day);
+
+    Wt::Dbo::Call hourly = execute(
+        "insert into climate_rollup "
+        "(hothouse_id, metric, resolution, bucket_start, min_value, max_value, sum_value, value_count) "
+        "select hothouse_id, metric, " + std::to_string(hour) + ", " + hour_bucket + ", "
+        "min(value), max(value), sum(value), count(1) "
+        "from climate_reading where " + span_conditions(hours.size(), "measured_at") + " "
+        "group by hothouse_id, metric, " + hour_bucket + upsert);
+    bind_spans(hourly, hours);
+    hourly.run();
+
+    Wt::Dbo::Call daily = execute(
+        "insert into climate_rollup "
+        "(hothouse_id, metric, resolution, bucket_start, min_value, max_value, sum_value, value_count) "
+        "select hothouse_id, metric, " + std::to_string(day) + ", " + day_bucket + ", "
+        "min(min_value), max(max_value), sum(sum_value), sum(value_count) "
+        "from climate_rollup where resolution = " + std::to_string(hour) + " and " +
+        span_conditions(days.size(), "bucket_start") + " "
+        "group by hothouse_id, metric, " + day_bucket + upsert);
+    bind_spans(daily, days);
+    daily.run();
+}
+
+std::vector<climate_rollup> session::climate_rollups(
+    long long hothouse_id,
+    climate_metric metric,
+    climate_resolution resolution,
+    std::int64_t from,
+    std::int64_t to)
+{
+    Wt::Dbo::collection<climate_rollup_row> rows = query<climate_rollup_row>(
+        "select bucket_start, min_value, max_value, sum_value / value_count, value_count from climate_rollup")
+        .where("hothouse_id = ? and metric = ? and resolution = ?")
+        .bind(hothouse_id).bind(static_cast<int>(metric)).bind(static_cast<int>(resolution))
+        .where("bucket_start >= ? and bucket_start < ?")
+        .bind(static_cast<long long>(from)).bind(static_cast<long long>(to))
+        .orderBy("bucket_start");
+
+    std::vector<climate_rollup> rollups;
+    for (const climate_rollup_row& row : rows)
     {
-        return Wt::Dbo::ptr<models::user_account>();
+        climate_rollup rollup;
+        rollup.bucket_start = std::get<0>(row);
+        rollup.min = std::get<1>(row);
+        rollup.max = std::get<2>(row);
+        rollup.mean = std::get<3>(row);
+        rollup.count = std::get<4>(row);
+        rollups.push_back(rollup);
     }
+    return rollups;
 }
 
 void session::configure_auth()
 {
     auto verifier = std::make_unique<Wt::Auth::PasswordVerifier>();
     verifier->addHashFunction(std::make_unique<Wt::Auth::BCryptHashFunction>(12));
-    password_service.setVerifier(std::move(verifier));
+    password_service.setVerifier(std::make_unique<primed_verifier>(std::move(verifier)));
     password_service.setStrengthValidator(std::make_unique<Wt::Auth::PasswordStrengthValidator>());
 }
 
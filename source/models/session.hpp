@@ -9,10 +9,22 @@
 #include <Wt/Dbo/Session.h>
 #include <Wt/Dbo/SqlConnectionPool.h>
 
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
 #include "works.hpp"
 #include "hothouse.hpp"
 #include "schedules.hpp"
 #include "crop.hpp"
+#include "catalog_record.hpp"
+#include "climate.hpp"
+#include "crop_summary.hpp"
+#include "date_set.hpp"
+#include "hothouse_reading.hpp"
+#include "hothouse_summary.hpp"
+#include "season_dates.hpp"
 #include "user_account.hpp"
 
 namespace agromaster
@@ -34,26 +46,100 @@ public:
         mapClass<agromaster::models::AuthInfo::AuthIdentityType>("auth_identity");
         mapClass<agromaster::models::AuthInfo::AuthTokenType>("auth_token");
         mapClass<agromaster::models::crop>("crop");
-        mapClass<agromaster::models::fertilizer_schedules>("fertilizer_schedules");
-        mapClass<agromaster::models::watering_schedules>("watering_schedules");
         mapClass<agromaster::models::schedules>("schedules");
         mapClass<agromaster::models::hothouse>("hothouse");
-        mapClass<agromaster::models::fertilizer_works>("fertilizer_works");
-        mapClass<agromaster::models::watering_works>("watering_works");
         mapClass<agromaster::models::works>("works");
+        login_.changed().connect([this] { user_resolved_ = false; });
     }
 
-    Wt::Dbo::ptr<user_account> user() const;
+    // Account of the logged in user, resolved on the first call after a login and cached
+    // until the login changes; a first login gets a new visitor account. Null when logged out.
+    // The first call after a login must be made inside a transaction.
+    Wt::Dbo::ptr<user_account> user();
+    enum user_account::role user_role();
+    const Wt::WString& login_name();
     UserDatabase& users() { return *users_; };
     Wt::Auth::Login& login() { return login_; }
 
+    // Loads every crop with its hothouse count and totals in one grouped query.
+    // Must be called inside a transaction.
+    std::vector<crop_summary> crop_summaries();
+
+    // Keyset page of hothouses in id order, starting right after after_id.
+    // Must be called inside a transaction.
+    std::vector<hothouse_summary> hothouse_summaries_after(long long after_id, int limit);
+    // Offset page of hothouses in id order, for jumps past the last known keyset boundary.
+    // Must be called inside a transaction.
+    std::vector<hothouse_summary> hothouse_summaries_from(int offset, int limit);
+    std::vector<hothouse_summary> hothouse_summaries(const std::set<long long>& ids);
+    int hothouses_count();
+
+    // Adds each reading to the totals of the hothouse with its title, one update per reading,
+    // and collects the ids of the touched hothouses and their crops. Returns the titles that
+    // matched no hothouse. Must be called inside a transaction.
+    std::vector<std::string> add_hothouse_readings(
+        const std::vector<hothouse_reading>& readings,
+        std::set<long long>& hothouse_ids,
+        std::set<long long>& crop_ids);
+
+    // The works of the hothouse, or the schedules of the crop, read by one single-row query
+    // on the works or schedules table. Return false when the hothouse or the crop is gone.
+    // Must be called inside a transaction.
+    bool hothouse_works(long long hothouse_id, season_dates& works);
+    bool crop_schedules(long long crop_id, season_dates& schedules);
+
+    // Keyset pages in id order, starting right after after_id, of the crops with their
+    // schedules and hothouse totals and of the hothouses with their crop titles and works.
+    // Must be called inside a transaction.
+    std::vector<crop_export> crop_exports_after(long long after_id, int limit);
+    std::vector<hothouse_export> hothouse_exports_after(long long after_id, int limit);
+
+    // Id by title of every crop. Must be called inside a transaction.
+    std::map<std::string, long long> crop_ids_by_title();
+    // Id by title of the hothouses among titles. Must be called inside a transaction.
+    std::map<std::string, long long> hothouse_ids_by_title(const std::vector<std::string>& titles);
+    // Insert the records with multi-row inserts, each crop with its schedules row and each
+    // hothouse with its works row, and return the ids of the new rows by title. Titles must
+    // be new. Must be called inside a transaction.
+    std::map<std::string, long long> insert_crops(const std::vector<crop_record>& crops);
+    std::map<std::string, long long> insert_hothouses(const std::vector<hothouse_record>& hothouses);
+
+    // Whether climate_reading is a partitioned Postgres table. Must be called inside a
+    // transaction, which is spoiled on other backends by the failed probe.
+    bool climate_readings_partitioned();
+    // Creates the monthly partition of climate_reading named name for [from, to), unless it
+    // exists already. Postgres only. Must be called inside a transaction.
+    void create_climate_partition(const std::string& name, std::int64_t from, std::int64_t to);
+    // The ids among ids that belong to a hothouse. Must be called inside a transaction.
+    std::set<long long> existing_hothouses(const std::set<long long>& ids);
+    // Inserts the points with multi-row inserts; points already stored are skipped, so a
+    // retried batch is harmless. Must be called inside a transaction.
+    void append_climate_points(const std::vector<climate_point>& points);
+    // Recomputes the hourly rollups overlapping the spans from the raw points, and the daily
+    // rollups of their days from the hourly ones. Spans of a hothouse should be sorted and
+    // disjoint; each costs three bind parameters. Must be called inside a transaction.
+    void refresh_climate_rollups(const std::vector<climate_span>& spans);
+    // Rollups of the buckets starting in [from, to), in time order; never reads raw points.
+    // Must be called inside a transaction.
+    std::vector<climate_rollup> climate_rollups(
+        long long hothouse_id,
+        climate_metric metric,
+        climate_resolution resolution,
+        std::int64_t from,
+        std::int64_t to);
+
     static void configure_auth();
     static const Wt::Auth::AuthService& auth();
     static const Wt::Auth::PasswordService& password_auth();
 
 private:
+    void resolve_user();
+
     std::unique_ptr<UserDatabase> users_;
     Wt::Auth::Login login_;
+    bool user_resolved_ = false;
+    Wt::Dbo::ptr<user_account> user_;
+    Wt::WString login_name_;
 };
 
 } // models
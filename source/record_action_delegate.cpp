@@ -0,0 +1,58 @@
+#include "record_action_delegate.hpp"
+
+#include <string>
+#include <utility>
+
+#include <Wt/WAny.h>
+#include <Wt/WModelIndex.h>
+#include <Wt/WText.h>
+
+namespace
+{
+
+// Names a cell widget after the column and the record it acts on.
+std::string cell_name(int column, long long id)
+{
+    return "record-action-" + std::to_string(column) + "-" + std::to_string(id);
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+record_action_delegate::record_action_delegate(action_type action)
+    : action_(std::move(action))
+{
+}
+
+std::unique_ptr<Wt::WWidget> record_action_delegate::update(
+    Wt::WWidget* widget,
+    const Wt::WModelIndex& index,
+    Wt::WFlags<Wt::ViewItemRenderFlag>)
+{
+    const Wt::cpp17::any id_data = index.data(Wt::ItemDataRole::User);
+    const long long id = id_data.has_value() ? Wt::cpp17::any_cast<long long>(id_data) : 0;
+    const int column = index.column();
+    const std::string name = cell_name(column, id);
+    if (widget && widget->objectName() == name)
+    {
+        return nullptr;
+    }
+
+    auto cell = std::make_unique<Wt::WText>(Wt::asString(index.data()));
+    cell->setObjectName(name);
+    cell->setStyleClass(Wt::asString(index.data(Wt::ItemDataRole::StyleClass)));
+    if (id > 0)
+    {
+        const action_type action = action_;
+        cell->clicked().connect(
+            [action, column, id]
+        {
+            action(column, id);
+        });
+    }
+    return std::move(cell);
+}
+
+} // agromaster
\ No newline at end of file
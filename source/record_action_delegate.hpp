@@ -0,0 +1,36 @@
+#pragma once
+#ifndef AGROMASTER_RECORD_ACTION_DELEGATE_HPP_
+#define AGROMASTER_RECORD_ACTION_DELEGATE_HPP_
+
+#include <functional>
+#include <memory>
+
+#include <Wt/WAbstractItemDelegate.h>
+
+namespace agromaster
+{
+
+// Renders the action cells of a table (works, change, delete) as clickable text bound to
+// the record id the model reports under Wt::ItemDataRole::User when the cell is drawn.
+// A click thus reaches the record the user saw, even when a change pushed from another
+// session has moved the rows since; a cell whose row now holds another record is drawn
+// anew, and the stale cell's clicks are dropped with it.
+class record_action_delegate final : public Wt::WAbstractItemDelegate
+{
+public:
+    using action_type = std::function<void(int column, long long id)>;
+
+    explicit record_action_delegate(action_type action);
+
+    std::unique_ptr<Wt::WWidget> update(
+        Wt::WWidget* widget,
+        const Wt::WModelIndex& index,
+        Wt::WFlags<Wt::ViewItemRenderFlag> flags) override;
+
+private:
+    const action_type action_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_RECORD_ACTION_DELEGATE_HPP_
\ No newline at end of file
@@ -0,0 +1,277 @@
+#include "sql_monitor.hpp"
+
+#include <Wt/WLogger.h>
+
+#include "configuration.hpp"
+#include "metrics.hpp"
+
+namespace
+{
+
+using agromaster::sql_monitor;
+
+// Long statements are cut to this many characters in the log.
+constexpr std::size_t logged_sql_length = 300;
+
+struct transaction_state
+{
+    bool active = false;
+    std::chrono::steady_clock::time_point started;
+    std::uint64_t statements_before = 0;
+    sql_monitor::duration statement_time = sql_monitor::duration::zero();
+};
+
+thread_local std::uint64_t thread_statement_count = 0;
+thread_local transaction_state current_transaction;
+
+sql_monitor::settings& monitor_settings()
+{
+    static sql_monitor::settings config;
+    return config;
+}
+
+const char* handler_name()
+{
+    const char* handler = agromaster::metrics::handler_scope::current();
+    return handler ? handler : "(no handler)";
+}
+
+long long to_milliseconds(sql_monitor::duration elapsed)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+std::string shortened(const std::string& sql)
+{
+    return sql.size() > logged_sql_length ? sql.substr(0, logged_sql_length) + "..." : sql;
+}
+
+} // unnamed namespace
+
+namespace agromaster
+{
+
+sql_monitor::settings sql_monitor::settings::load(const Wt::WServer& server)
+{
+    using namespace configuration;
+
+    settings config;
+    read_duration(server, "AGROMASTER_SQL_SLOW_STATEMENT", "agromaster-sql-slow-statement", config.slow_statement);
+    read_duration(server, "AGROMASTER_SQL_SLOW_TRANSACTION", "agromaster-sql-slow-transaction", config.slow_transaction);
+    read_number(server, "AGROMASTER_SQL_MAX_STATEMENTS", "agromaster-sql-max-statements", config.max_statements);
+    return config;
+}
+
+void sql_monitor::configure(const settings& config)
+{
+    monitor_settings() = config;
+}
+
+const sql_monitor::settings& sql_monitor::current_settings()
+{
+    return monitor_settings();
+}
+
+std::uint64_t sql_monitor::thread_statements()
+{
+    return thread_statement_count;
+}
+
+void sql_monitor::statement_executed(const std::string& sql, duration elapsed)
+{
+    ++thread_statement_count;
+    if (current_transaction.active)
+    {
+        current_transaction.statement_time += elapsed;
+    }
+    if (elapsed > monitor_settings().slow_statement)
+    {
+        Wt::log("warning")
+            << "sql_monitor: slow statement (" << to_milliseconds(elapsed) << " ms) in "
+            << handler_name() << ": " << shortened(sql);
+    }
+}
+
+void sql_monitor::transaction_started()
+{
+    current_transaction.active = true;
+    current_transaction.started = std::chrono::steady_clock::now();
+    current_transaction.statements_before = thread_statement_count;
+    current_transaction.statement_time = duration::zero();
+}
+
+void sql_monitor::transaction_finished(bool committed)
+{
+    if (!current_transaction.active)
+    {
+        return;
+    }
+    current_transaction.active = false;
+
+    const duration elapsed = std::chrono::steady_clock::now() - current_transaction.started;
+    const std::uint64_t statements = thread_statement_count - current_transaction.statements_before;
+    const settings& config = monitor_settings();
+    if (elapsed > config.slow_transaction || statements > static_cast<std::uint64_t>(config.max_statements))
+    {
+        Wt::log("warning")
+            << "sql_monitor: " << (committed ? "committed" : "rolled back") << " transaction in "
+            << handler_name() << " ran " << statements << " statements in "
+            << to_milliseconds(elapsed) << " ms (" << to_milliseconds(current_transaction.statement_time)
+            << " ms executing)";
+    }
+}
+
+void sql_monitor::action_finished(const char* handler, std::uint64_t statements, duration elapsed)
+{
+    if (statements > static_cast<std::uint64_t>(monitor_settings().max_statements))
+    {
+        Wt::log("warning")
+            << "sql_monitor: " << handler << " issued " << statements << " statements in "
+            << to_milliseconds(elapsed) << " ms (limit " << monitor_settings().max_statements << ")";
+    }
+}
+
+instrumented_statement::instrumented_statement(std::unique_ptr<Wt::Dbo::SqlStatement> statement)
+    : statement_(std::move(statement))
+{
+}
+
+void instrumented_statement::reset()
+{
+    statement_->reset();
+}
+
+void instrumented_statement::bind(int column, const std::string& value)
+{
+    statement_->bind(column, value);
+}
+
+void instrumented_statement::bind(int column, short value)
+{
+    statement_->bind(column, value);
+}
+
+void instrumented_statement::bind(int column, int value)
+{
+    statement_->bind(column, value);
+}
+
+void instrumented_statement::bind(int column, long long value)
+{
+    statement_->bind(column, value);
+}
+
+void instrumented_statement::bind(int column, float value)
+{
+    statement_->bind(column, value);
+}
+
+void instrumented_statement::bind(int column, double value)
+{
+    statement_->bind(column, value);
+}
+
+void instrumented_statement::bind(
+    int column,
+    const std::chrono::system_clock::time_point& value,
+    Wt::Dbo::SqlDateTimeType type)
+{
+    statement_->bind(column, value, type);
+}
+
+void instrumented_statement::bind(int column, const std::chrono::duration<int, std::milli>& value)
+{
+    statement_->bind(column, value);
+}
+
+void instrumented_statement::bind(int column, const std::vector<unsigned char>& value)
+{
+    statement_->bind(column, value);
+}
+
+void instrumented_statement::bindNull(int column)
+{
+    statement_->bindNull(column);
+}
+
+void instrumented_statement::execute()
+{
+    const auto started = std::chrono::steady_clock::now();
+    statement_->execute();
+    sql_monitor::statement_executed(statement_->sql(), std::chrono::steady_clock::now() - started);
+}
+
+long long instrumented_statement::insertedId()
+{
+    return statement_->insertedId();
+}
+
+int instrumented_statement::affectedRowCount()
+{
+    return statement_->affectedRowCount();
+}
+
+bool instrumented_statement::nextRow()
+{
+    return statement_->nextRow();
+}
+
+int instrumented_statement::columnCount() const
+{
+    return statement_->columnCount();
+}
+
+bool instrumented_statement::getResult(int column, std::string* value, int size)
+{
+    return statement_->getResult(column, value, size);
+}
+
+bool instrumented_statement::getResult(int column, short* value)
+{
+    return statement_->getResult(column, value);
+}
+
+bool instrumented_statement::getResult(int column, int* value)
+{
+    return statement_->getResult(column, value);
+}
+
+bool instrumented_statement::getResult(int column, long long* value)
+{
+    return statement_->getResult(column, value);
+}
+
+bool instrumented_statement::getResult(int column, float* value)
+{
+    return statement_->getResult(column, value);
+}
+
+bool instrumented_statement::getResult(int column, double* value)
+{
+    return statement_->getResult(column, value);
+}
+
+bool instrumented_statement::getResult(
+    int column,
+    std::chrono::system_clock::time_point* value,
+    Wt::Dbo::SqlDateTimeType type)
+{
+    return statement_->getResult(column, value, type);
+}
+
+bool instrumented_statement::getResult(int column, std::chrono::duration<int, std::milli>* value)
+{
+    return statement_->getResult(column, value);
+}
+
+bool instrumented_statement::getResult(int column, std::vector<unsigned char>* value, int size)
+{
+    return statement_->getResult(column, value, size);
+}
+
+std::string instrumented_statement::sql() const
+{
+    return statement_->sql();
+}
+
+} // agromaster
\ No newline at end of file
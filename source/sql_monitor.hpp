@@ -0,0 +1,146 @@
+#pragma once
+#ifndef AGROMASTER_SQL_MONITOR_HPP_
+#define AGROMASTER_SQL_MONITOR_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Wt/Dbo/SqlConnection.h>
+#include <Wt/Dbo/SqlStatement.h>
+#include <Wt/WServer.h>
+
+namespace agromaster
+{
+
+// Counts and times the SQL statements run by each thread and logs the outliers: single
+// statements slower than slow_statement, transactions slower than slow_transaction or
+// with more than max_statements statements, and user actions (the outermost
+// metrics::handler_scope) with more than max_statements statements. Each report names
+// the handler the work was done for, so a query explosion can be traced to its action.
+//
+// Statements are only seen on connections wrapped in instrumented_connection.
+class sql_monitor
+{
+public:
+    using duration = std::chrono::steady_clock::duration;
+
+    struct settings
+    {
+        std::chrono::milliseconds slow_statement{ 100 };
+        std::chrono::milliseconds slow_transaction{ 500 };
+        int max_statements = 50;
+
+        static settings load(const Wt::WServer& server);
+    };
+
+    // Not synchronized; call before the server starts handling requests.
+    static void configure(const settings& config);
+    static const settings& current_settings();
+
+    // Statements run on this thread so far; the difference of two readings is the number
+    // of statements in between.
+    static std::uint64_t thread_statements();
+
+    static void statement_executed(const std::string& sql, duration elapsed);
+    static void transaction_started();
+    static void transaction_finished(bool committed);
+    static void action_finished(const char* handler, std::uint64_t statements, duration elapsed);
+};
+
+// Forwards everything to the backend statement and reports each execution to sql_monitor.
+class instrumented_statement final : public Wt::Dbo::SqlStatement
+{
+public:
+    explicit instrumented_statement(std::unique_ptr<Wt::Dbo::SqlStatement> statement);
+
+    void reset() override;
+    void bind(int column, const std::string& value) override;
+    void bind(int column, short value) override;
+    void bind(int column, int value) override;
+    void bind(int column, long long value) override;
+    void bind(int column, float value) override;
+    void bind(int column, double value) override;
+    void bind(int column, const std::chrono::system_clock::time_point& value, Wt::Dbo::SqlDateTimeType type) override;
+    void bind(int column, const std::chrono::duration<int, std::milli>& value) override;
+    void bind(int column, const std::vector<unsigned char>& value) override;
+    void bindNull(int column) override;
+    void execute() override;
+    long long insertedId() override;
+    int affectedRowCount() override;
+    bool nextRow() override;
+    int columnCount() const override;
+    bool getResult(int column, std::string* value, int size) override;
+    bool getResult(int column, short* value) override;
+    bool getResult(int column, int* value) override;
+    bool getResult(int column, long long* value) override;
+    bool getResult(int column, float* value) override;
+    bool getResult(int column, double* value) override;
+    bool getResult(int column, std::chrono::system_clock::time_point* value, Wt::Dbo::SqlDateTimeType type) override;
+    bool getResult(int column, std::chrono::duration<int, std::milli>* value) override;
+    bool getResult(int column, std::vector<unsigned char>* value, int size) override;
+    std::string sql() const override;
+
+private:
+    std::unique_ptr<Wt::Dbo::SqlStatement> statement_;
+};
+
+// A Wt::Dbo backend connection whose statements and transactions are reported to
+// sql_monitor, e.g. instrumented_connection<Wt::Dbo::backend::Postgres>.
+template <typename Backend>
+class instrumented_connection final : public Backend
+{
+public:
+    template <typename... Args>
+    explicit instrumented_connection(Args&&... args)
+        : Backend(std::forward<Args>(args)...)
+    {
+    }
+
+    instrumented_connection(const instrumented_connection& other)
+        : Backend(other)
+    {
+    }
+
+    std::unique_ptr<Wt::Dbo::SqlConnection> clone() const override
+    {
+        return std::make_unique<instrumented_connection>(*this);
+    }
+
+    void executeSql(const std::string& sql) override
+    {
+        const auto started = std::chrono::steady_clock::now();
+        Backend::executeSql(sql);
+        sql_monitor::statement_executed(sql, std::chrono::steady_clock::now() - started);
+    }
+
+    void startTransaction() override
+    {
+        Backend::startTransaction();
+        sql_monitor::transaction_started();
+    }
+
+    void commitTransaction() override
+    {
+        Backend::commitTransaction();
+        sql_monitor::transaction_finished(true);
+    }
+
+    void rollbackTransaction() override
+    {
+        Backend::rollbackTransaction();
+        sql_monitor::transaction_finished(false);
+    }
+
+    std::unique_ptr<Wt::Dbo::SqlStatement> prepareStatement(const std::string& sql) override
+    {
+        return std::make_unique<instrumented_statement>(Backend::prepareStatement(sql));
+    }
+};
+
+} // agromaster
+
+#endif // AGROMASTER_SQL_MONITOR_HPP_
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "validation.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace agromaster
+{
+
+bool parse_quantity(const std::string& text, double& quantity)
+{
+    if (text.empty())
+    {
+        quantity = 0.0;
+        return true;
+    }
+    char* end = nullptr;
+    quantity = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && std::isfinite(quantity) && quantity >= 0.0;
+}
+
+} // agromaster
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#ifndef AGROMASTER_VALIDATION_HPP_
+#define AGROMASTER_VALIDATION_HPP_
+
+#include <cstddef>
+#include <string>
+
+namespace agromaster
+{
+
+// Longest crop or hothouse title, in characters: the size of their title columns.
+constexpr std::size_t max_title_length = 30;
+
+// Yields and spent fertilizers as the import and ingest endpoints read them. Empty text is
+// a quantity of 0; anything else must be a finite, non-negative decimal number, as in the
+// hothouse dialog.
+bool parse_quantity(const std::string& text, double& quantity);
+
+} // agromaster
+
+#endif // AGROMASTER_VALIDATION_HPP_
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "worker_pool.hpp"
+
+#include <exception>
+
+#include <Wt/WLogger.h>
+
+namespace agromaster
+{
+
+worker_pool::worker_pool(std::size_t threads, std::size_t max_queued)
+    : max_queued_(max_queued)
+{
+    threads_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        threads_.emplace_back(&worker_pool::run, this);
+    }
+}
+
+worker_pool::~worker_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+bool worker_pool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || tasks_.size() >= max_queued_)
+        {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+    return true;
+}
+
+std::size_t worker_pool::queued() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void worker_pool::run()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+            {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception& error)
+        {
+            Wt::log("error") << "worker_pool: task failed: " << error.what();
+        }
+    }
+}
+
+} // agromaster
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef AGROMASTER_WORKER_POOL_HPP_
+#define AGROMASTER_WORKER_POOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agromaster
+{
+
+// Fixed set of threads running queued tasks, kept apart from the Wt request threads so
+// CPU heavy work cannot occupy them. The queue is bounded: submit() refuses new tasks
+// instead of letting a burst pile up without limit. Tasks still queued when the pool is
+// destroyed are run before its threads are joined.
+class worker_pool
+{
+public:
+    worker_pool(std::size_t threads, std::size_t max_queued);
+    ~worker_pool();
+
+    worker_pool(const worker_pool&) = delete;
+    worker_pool& operator=(const worker_pool&) = delete;
+
+    // Returns false, and drops the task, when max_queued tasks are already waiting.
+    bool submit(std::function<void()> task);
+    std::size_t queued() const;
+
+private:
+    void run();
+
+    const std::size_t max_queued_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+} // agromaster
+
+#endif // AGROMASTER_WORKER_POOL_HPP_
\ No newline at end of file